@@ -0,0 +1,768 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "bitcpy.h"
+
+/*
+ * 基准测试套件：对 bitcpy 及各基线实现按长度和 (src_bit, dest_bit) 扫描，
+ * 每个组合重复测量，输出中位数和 p99，结果为 CSV 或 JSON，可与保存的基线对比。
+ *
+ * 用法：
+ *   ./bench [--quick] [--format csv|json] [--out FILE] [--reps N]
+ *           [--max-bytes N] [--pairs all|few] [--compare BASELINE.csv] [--threshold PCT]
+ *           [--replay TRACE]
+ *
+ * - --quick：长度最大 1 MiB，只测代表性的位偏移组合，重复 11 次（日常回归用）
+ * - --max-bytes：最大拷贝长度（字节），默认 1 GiB；分配失败时自动减半
+ * - --pairs：all 对所有长度测全部 64 种位偏移组合；默认 1 Mbit 以内测全部组合，更长只测代表性组合
+ * - --compare：读取之前以 CSV 保存的结果，按 (func, len_bits, src_bit, dest_bit) 匹配，
+ *   中位耗时变慢超过阈值（--threshold，正数，默认 5%）的组合打印到 stderr，存在回归时退出码为 1
+ * - --replay：不做扫描，按 BITCPY_TRACE 记录的调用文件（见 bitcpy.h）重放，
+ *   每行结果是一个函数把整个记录重放一遍的耗时（见 run_replay）
+ *
+ * 每个样本把同一次调用连续执行 inner 次（inner 自动校准到样本耗时 >= 20 us），
+ * 记录每次调用的 TSC 周期数（x86）和纳秒数。源和目标缓冲区在各次调用之间复用，
+ * 小长度测的是缓存命中时的开销，大长度测的是内存带宽。
+ * Linux 上通过 perf_event_open 统计缓存未命中和分支预测失败（每次调用的平均值），
+ * 无权限或不支持时输出 -1。
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+static double now_ns(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e9 / (double)freq.QuadPart;
+}
+#else
+#include <time.h>
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+static inline uint64_t read_tsc(void) {
+    return __rdtsc();
+}
+#else
+static inline uint64_t read_tsc(void) {
+    return 0;
+}
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define HAVE_PERF 1
+#endif
+
+#define MIN_SAMPLE_NS 20000.0
+#define MAX_INNER (1u << 20)
+#define EXPANDED_MAX_BITS (1u << 16)  // 1 字节/位的基线只测到这个长度
+#define FULL_PAIRS_MAX_BITS (1u << 20)
+
+// ---------------------------------------------------------------------------
+// 被测函数
+
+// 基线：逐位拷贝（紧凑存储）
+static void copy_bitwise(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    for (uint64_t i = 0; i < len; i++) {
+        uint64_t src_pos = src_bit + i;
+        uint64_t dest_pos = dest_bit + i;
+        uint8_t mask = (uint8_t)(1u << (dest_pos & 7));
+        if ((src[src_pos >> 3] >> (src_pos & 7)) & 1) {
+            dest[dest_pos >> 3] |= mask;
+        } else {
+            dest[dest_pos >> 3] &= (uint8_t)~mask;
+        }
+    }
+}
+
+// 基线：1 字节表示 1 位的展开存储，拷贝即 memcpy
+static void copy_expanded(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    memcpy(dest + dest_bit, src + src_bit, (size_t)len);
+}
+
+// 基线：按字节 memcpy（不处理位偏移，只作为带宽上限参考）
+static void copy_memcpy(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    (void)dest_bit; (void)src_bit;
+    memcpy(dest, src, (size_t)((len + 7) >> 3));
+}
+
+typedef void (*copy_fn)(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+typedef struct {
+    const char* name;
+    copy_fn fn;
+    uint64_t max_bits;  // 只测 len <= max_bits，0 表示不限
+    int offsets;        // 0 表示与位偏移无关，只测 (0, 0)
+    int expanded;       // 缓冲区按 1 字节/位分配
+} bench_func;
+
+static const bench_func funcs[] = {
+    {"bitcpy", bitcpy, 0, 1, 0},
+    {"bitcpy_stream", bitcpy_stream, 0, 1, 0},
+    {"bitcpy_msb", bitcpy_msb, 0, 1, 0},
+    {"memcpy", copy_memcpy, 0, 0, 0},
+    {"bitwise", copy_bitwise, EXPANDED_MAX_BITS, 1, 0},
+    {"expanded", copy_expanded, EXPANDED_MAX_BITS, 1, 1},
+};
+
+// 长度扫描（位）：覆盖快速路径、阶段1-4 的各种组合和大块带宽
+static const uint64_t lengths[] = {
+    1, 3, 7, 8, 13, 31, 64, 100, 200, 512, 1000, 4096, 1u << 14, 1u << 16,
+    1u << 20, (uint64_t)1 << 23, (uint64_t)1 << 26, (uint64_t)1 << 29, (uint64_t)1 << 33,
+};
+
+// 长拷贝只测的代表性位偏移组合
+static const uint8_t few_pairs[][2] = {{0, 0}, {3, 0}, {0, 5}, {5, 2}};
+
+// ---------------------------------------------------------------------------
+// 硬件计数器
+
+typedef struct {
+    int fd_cache;
+    int fd_branch;
+} perf_counters;
+
+#ifdef HAVE_PERF
+static int perf_open(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void perf_init(perf_counters* pc) {
+    pc->fd_cache = perf_open(PERF_COUNT_HW_CACHE_MISSES);
+    pc->fd_branch = perf_open(PERF_COUNT_HW_BRANCH_MISSES);
+}
+
+static void perf_start(const perf_counters* pc) {
+    if (pc->fd_cache >= 0) {
+        ioctl(pc->fd_cache, PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd_cache, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    if (pc->fd_branch >= 0) {
+        ioctl(pc->fd_branch, PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd_branch, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static int64_t perf_read(int fd) {
+    uint64_t value;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) return -1;
+    return (int64_t)value;
+}
+
+static void perf_close(perf_counters* pc) {
+    if (pc->fd_cache >= 0) close(pc->fd_cache);
+    if (pc->fd_branch >= 0) close(pc->fd_branch);
+}
+#else
+static void perf_init(perf_counters* pc) {
+    pc->fd_cache = -1;
+    pc->fd_branch = -1;
+}
+static void perf_start(const perf_counters* pc) { (void)pc; }
+static int64_t perf_read(int fd) { (void)fd; return -1; }
+static void perf_close(perf_counters* pc) { (void)pc; }
+#endif
+
+// ---------------------------------------------------------------------------
+// 测量
+
+typedef struct {
+    const char* func;
+    uint64_t len;
+    unsigned src_bit;
+    unsigned dest_bit;
+    unsigned reps;
+    unsigned inner;
+    double median_cpb;   // 每位 TSC 周期数，无 TSC 时为 -1
+    double p99_cpb;
+    double median_ns;    // 每次调用的纳秒数
+    double p99_ns;
+    double median_gbps;  // 按 len / 8 字节计算
+    double p99_gbps;
+    double cache_misses;   // 每次调用的平均值，不可用时为 -1
+    double branch_misses;
+} bench_result;
+
+typedef struct {
+    const char* format;
+    const char* out_path;
+    const char* compare_path;
+    double threshold;
+    unsigned reps;
+    uint64_t max_bytes;
+    int all_pairs;
+    int quick;
+    const char* replay_path;
+} bench_options;
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 排序后取分位数（p 为 0-1），p99 取向上取整的秩
+static double percentile(double* v, unsigned n, double p) {
+    unsigned rank = (unsigned)(p * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return v[rank - 1];
+}
+
+// 返回 0 成功；-1 样本数组分配失败，r 未填写
+static int measure(const bench_func* f, copy_fn fn, uint8_t* dest, const uint8_t* src,
+                   uint64_t len, unsigned src_bit, unsigned dest_bit, unsigned reps,
+                   const perf_counters* pc, bench_result* r) {
+    // 校准：单个样本至少 MIN_SAMPLE_NS
+    unsigned inner = 1;
+    for (;;) {
+        double t0 = now_ns();
+        for (unsigned i = 0; i < inner; i++) {
+            fn(dest, (uint8_t)dest_bit, src, (uint8_t)src_bit, len);
+        }
+        double elapsed = now_ns() - t0;
+        if (elapsed >= MIN_SAMPLE_NS || inner >= MAX_INNER) break;
+        unsigned next = elapsed > 0 ? (unsigned)(inner * (MIN_SAMPLE_NS / elapsed) * 1.2) + 1 : inner * 16;
+        inner = next > MAX_INNER ? MAX_INNER : (next > inner ? next : inner * 2);
+    }
+
+    double* cycles = (double*)malloc(reps * sizeof(double));
+    double* ns = (double*)malloc(reps * sizeof(double));
+    if (!cycles || !ns) {
+        free(cycles);
+        free(ns);
+        return -1;
+    }
+    perf_start(pc);
+    for (unsigned rep = 0; rep < reps; rep++) {
+        double t0 = now_ns();
+        uint64_t c0 = read_tsc();
+        for (unsigned i = 0; i < inner; i++) {
+            fn(dest, (uint8_t)dest_bit, src, (uint8_t)src_bit, len);
+        }
+        uint64_t c1 = read_tsc();
+        double t1 = now_ns();
+        cycles[rep] = (double)(c1 - c0) / inner;
+        ns[rep] = (t1 - t0) / inner;
+    }
+    int64_t cache = perf_read(pc->fd_cache);
+    int64_t branch = perf_read(pc->fd_branch);
+    qsort(cycles, reps, sizeof(double), cmp_double);
+    qsort(ns, reps, sizeof(double), cmp_double);
+
+    double calls = (double)reps * inner;
+    double bytes = (double)len / 8.0;
+    r->func = f->name;
+    r->len = len;
+    r->src_bit = src_bit;
+    r->dest_bit = dest_bit;
+    r->reps = reps;
+    r->inner = inner;
+#ifdef HAVE_TSC
+    r->median_cpb = percentile(cycles, reps, 0.5) / (double)len;
+    r->p99_cpb = percentile(cycles, reps, 0.99) / (double)len;
+#else
+    r->median_cpb = -1;
+    r->p99_cpb = -1;
+#endif
+    r->median_ns = percentile(ns, reps, 0.5);
+    r->p99_ns = percentile(ns, reps, 0.99);
+    r->median_gbps = bytes / r->median_ns;
+    r->p99_gbps = bytes / r->p99_ns;
+    r->cache_misses = cache < 0 ? -1 : (double)cache / calls;
+    r->branch_misses = branch < 0 ? -1 : (double)branch / calls;
+    free(cycles);
+    free(ns);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 输出与对比
+
+static const char* csv_header =
+    "func,len_bits,src_bit,dest_bit,reps,inner,median_cycles_per_bit,p99_cycles_per_bit,"
+    "median_ns,p99_ns,median_gbps,p99_gbps,cache_misses,branch_misses\n";
+
+static void write_result(FILE* out, const char* format, const bench_result* r, int first) {
+    if (strcmp(format, "json") == 0) {
+        fprintf(out, "%s  {\"func\": \"%s\", \"len_bits\": %llu, \"src_bit\": %u, \"dest_bit\": %u, "
+                "\"reps\": %u, \"inner\": %u, \"median_cycles_per_bit\": %.6g, \"p99_cycles_per_bit\": %.6g, "
+                "\"median_ns\": %.6g, \"p99_ns\": %.6g, \"median_gbps\": %.6g, \"p99_gbps\": %.6g, "
+                "\"cache_misses\": %.6g, \"branch_misses\": %.6g}",
+                first ? "" : ",\n", r->func, (unsigned long long)r->len, r->src_bit, r->dest_bit,
+                r->reps, r->inner, r->median_cpb, r->p99_cpb, r->median_ns, r->p99_ns,
+                r->median_gbps, r->p99_gbps, r->cache_misses, r->branch_misses);
+    } else {
+        fprintf(out, "%s,%llu,%u,%u,%u,%u,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g\n",
+                r->func, (unsigned long long)r->len, r->src_bit, r->dest_bit, r->reps, r->inner,
+                r->median_cpb, r->p99_cpb, r->median_ns, r->p99_ns, r->median_gbps, r->p99_gbps,
+                r->cache_misses, r->branch_misses);
+    }
+}
+
+typedef struct {
+    char func[32];
+    uint64_t len;
+    unsigned src_bit;
+    unsigned dest_bit;
+    double median_ns;
+} baseline_entry;
+
+// 读取 CSV 基线，只保留匹配和比较需要的字段；返回条目数，失败返回 -1
+static long load_baseline(const char* path, baseline_entry** out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    size_t cap = 256, n = 0;
+    baseline_entry* v = (baseline_entry*)malloc(cap * sizeof(baseline_entry));
+    char line[512];
+    while (v && fgets(line, sizeof(line), f)) {
+        baseline_entry e;
+        unsigned long long len;
+        unsigned reps, inner;
+        double cpb, p99_cpb;
+        if (sscanf(line, "%31[^,],%llu,%u,%u,%u,%u,%lf,%lf,%lf",
+                   e.func, &len, &e.src_bit, &e.dest_bit, &reps, &inner, &cpb, &p99_cpb, &e.median_ns) != 9) {
+            continue;  // 表头或无法解析的行
+        }
+        e.len = len;
+        if (n == cap) {
+            cap *= 2;
+            baseline_entry* grown = (baseline_entry*)realloc(v, cap * sizeof(baseline_entry));
+            if (!grown) break;
+            v = grown;
+        }
+        v[n++] = e;
+    }
+    fclose(f);
+    *out = v;
+    return v ? (long)n : -1;
+}
+
+// 返回 1 表示相对基线变慢超过阈值
+static int compare_result(const bench_result* r, const baseline_entry* base, long nbase, double threshold) {
+    for (long i = 0; i < nbase; i++) {
+        const baseline_entry* e = &base[i];
+        if (e->len == r->len && e->src_bit == r->src_bit && e->dest_bit == r->dest_bit &&
+            strcmp(e->func, r->func) == 0) {
+            double change = (r->median_ns - e->median_ns) / e->median_ns * 100.0;
+            if (change > threshold) {
+                fprintf(stderr, "REGRESSION %s len=%llu src_bit=%u dest_bit=%u: %.3g ns -> %.3g ns (+%.1f%%)\n",
+                        r->func, (unsigned long long)r->len, r->src_bit, r->dest_bit,
+                        e->median_ns, r->median_ns, change);
+                return 1;
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 调用记录重放
+
+#define REPLAY_ARENA_BYTES ((size_t)64 << 20)  // 源和目标各自的缓冲区，超过后从头复用
+
+typedef struct {
+    uint8_t* dest;
+    const uint8_t* src;
+    uint64_t len;
+    uint8_t dest_bit;
+    uint8_t src_bit;
+} replay_call;
+
+static const bench_func replay_funcs[] = {
+    {"replay:bitcpy", bitcpy, 0, 1, 0},
+    {"replay:bitcpy_padded", bitcpy_padded, 0, 1, 0},
+};
+
+// 读取记录文件，返回记录数，失败返回 -1
+static long load_trace(const char* path, uint64_t** out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    char magic[8];
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, BITCPY_TRACE_MAGIC, 8) != 0) {
+        fclose(f);
+        return -1;
+    }
+    size_t cap = 4096, n = 0;
+    uint64_t* v = (uint64_t*)malloc(cap * sizeof(uint64_t));
+    while (v) {
+        if (n == cap) {
+            cap *= 2;
+            uint64_t* grown = (uint64_t*)realloc(v, cap * sizeof(uint64_t));
+            if (!grown) {
+                free(v);
+                v = NULL;
+                break;
+            }
+            v = grown;
+        }
+        size_t got = fread(v + n, sizeof(uint64_t), cap - n, f);
+        n += got;
+        if (got == 0) break;
+    }
+    fclose(f);
+    *out = v;
+    return v ? (long)n : -1;
+}
+
+// 在缓冲区中为一次调用分配 bytes 字节，起点地址 mod 64 等于记录的值；放不下时从头复用
+static uint8_t* arena_take(uint8_t* base, size_t size, size_t* pos, unsigned align, size_t bytes) {
+    size_t p = (*pos + 63) & ~(size_t)63;
+    if (p + align + bytes > size) p = 0;
+    *pos = p + align + bytes;
+    return base + p + align;
+}
+
+/*
+ * 按记录重建调用：源和目标各用一块 64 MiB、按 64 字节对齐的缓冲区，
+ * 依次为每次调用分配区间（保留记录中的地址 mod 64 和位偏移，末尾留出 BITCPY_PAD_BYTES），
+ * 放满后从头复用，这样连续调用访问的是不同的缓存行，与原程序逐块处理数据的访问方式接近。
+ * 每个样本把整个记录按顺序执行一遍；结果行的 len_bits 为记录中的总位数，inner 为调用数，
+ * src_bit/dest_bit 为 0，ns 为每次调用的平均值，cycles_per_bit 和 GB/s 按总位数计算。
+ * 返回回归数，失败返回 -1。
+ */
+static int run_replay(const bench_options* opt, FILE* out, const baseline_entry* base, long nbase,
+                      const perf_counters* pc, unsigned* count) {
+    uint64_t* records = NULL;
+    long n = load_trace(opt->replay_path, &records);
+    if (n <= 0) {
+        fprintf(stderr, "cannot read trace %s\n", opt->replay_path);
+        free(records);
+        return -1;
+    }
+
+    uint64_t total_bits = 0;
+    size_t max_bytes = 0;
+    for (long i = 0; i < n; i++) {
+        bitcpy_trace_call c;
+        bitcpy_trace_decode(records[i], &c);
+        size_t bytes = (size_t)((c.len + 14) >> 3) + BITCPY_PAD_BYTES;
+        if (bytes > max_bytes) max_bytes = bytes;
+        total_bits += c.len;
+    }
+    size_t arena = REPLAY_ARENA_BYTES;
+    if (arena < max_bytes + 128) arena = max_bytes + 128;
+    uint8_t* src_arena = (uint8_t*)aligned_alloc(64, (arena + 63) & ~(size_t)63);
+    uint8_t* dest_arena = (uint8_t*)aligned_alloc(64, (arena + 63) & ~(size_t)63);
+    replay_call* calls = (replay_call*)malloc((size_t)n * sizeof(replay_call));
+    if (!src_arena || !dest_arena || !calls) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(records);
+        free(src_arena);
+        free(dest_arena);
+        free(calls);
+        return -1;
+    }
+    for (size_t i = 0; i < arena; i++) {
+        src_arena[i] = (uint8_t)rand();
+        dest_arena[i] = 0;
+    }
+    size_t src_pos = 0, dest_pos = 0;
+    for (long i = 0; i < n; i++) {
+        bitcpy_trace_call c;
+        bitcpy_trace_decode(records[i], &c);
+        calls[i].len = c.len;
+        calls[i].dest_bit = c.dest_bit;
+        calls[i].src_bit = c.src_bit;
+        calls[i].dest = arena_take(dest_arena, arena, &dest_pos, c.dest_align,
+                                   (size_t)((c.dest_bit + c.len + 7) >> 3) + BITCPY_PAD_BYTES);
+        calls[i].src = arena_take(src_arena, arena, &src_pos, c.src_align,
+                                  (size_t)((c.src_bit + c.len + 7) >> 3) + BITCPY_PAD_BYTES);
+    }
+    free(records);
+    fprintf(stderr, "replaying %ld calls, %llu bits\n", n, (unsigned long long)total_bits);
+
+    int regressions = 0;
+    double* cycles = (double*)malloc(opt->reps * sizeof(double));
+    double* ns = (double*)malloc(opt->reps * sizeof(double));
+    for (size_t fi = 0; cycles && ns && fi < sizeof(replay_funcs) / sizeof(replay_funcs[0]); fi++) {
+        const bench_func* f = &replay_funcs[fi];
+        for (long i = 0; i < n; i++) {  // 预热
+            f->fn(calls[i].dest, calls[i].dest_bit, calls[i].src, calls[i].src_bit, calls[i].len);
+        }
+        perf_start(pc);
+        for (unsigned rep = 0; rep < opt->reps; rep++) {
+            double t0 = now_ns();
+            uint64_t c0 = read_tsc();
+            for (long i = 0; i < n; i++) {
+                f->fn(calls[i].dest, calls[i].dest_bit, calls[i].src, calls[i].src_bit, calls[i].len);
+            }
+            uint64_t c1 = read_tsc();
+            double t1 = now_ns();
+            cycles[rep] = (double)(c1 - c0);
+            ns[rep] = t1 - t0;
+        }
+        int64_t cache = perf_read(pc->fd_cache);
+        int64_t branch = perf_read(pc->fd_branch);
+        qsort(cycles, opt->reps, sizeof(double), cmp_double);
+        qsort(ns, opt->reps, sizeof(double), cmp_double);
+
+        double ncalls = (double)opt->reps * (double)n;
+        double bits = total_bits ? (double)total_bits : 1.0;
+        bench_result r;
+        r.func = f->name;
+        r.len = total_bits;
+        r.src_bit = 0;
+        r.dest_bit = 0;
+        r.reps = opt->reps;
+        r.inner = (unsigned)n;
+#ifdef HAVE_TSC
+        r.median_cpb = percentile(cycles, opt->reps, 0.5) / bits;
+        r.p99_cpb = percentile(cycles, opt->reps, 0.99) / bits;
+#else
+        r.median_cpb = -1;
+        r.p99_cpb = -1;
+#endif
+        r.median_ns = percentile(ns, opt->reps, 0.5) / (double)n;
+        r.p99_ns = percentile(ns, opt->reps, 0.99) / (double)n;
+        r.median_gbps = bits / 8.0 / percentile(ns, opt->reps, 0.5);
+        r.p99_gbps = bits / 8.0 / percentile(ns, opt->reps, 0.99);
+        r.cache_misses = cache < 0 ? -1 : (double)cache / ncalls;
+        r.branch_misses = branch < 0 ? -1 : (double)branch / ncalls;
+        write_result(out, opt->format, &r, *count == 0);
+        (*count)++;
+        if (base) {
+            regressions += compare_result(&r, base, nbase, opt->threshold);
+        }
+    }
+    if (!cycles || !ns) {
+        fprintf(stderr, "memory allocation failed\n");
+        regressions = -1;
+    }
+    free(cycles);
+    free(ns);
+    free(calls);
+    free(src_arena);
+    free(dest_arena);
+    return regressions;
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--quick] [--format csv|json] [--out FILE] [--reps N] [--max-bytes N]\n"
+            "          [--pairs all|few] [--compare BASELINE.csv] [--threshold PCT] [--replay TRACE]\n", prog);
+}
+
+// 解析正的有限实数，整个字符串都必须是数字
+static int parse_positive(const char* v, double* out) {
+    char* end;
+    double x = strtod(v, &end);
+    if (end == v || *end != '\0' || !isfinite(x) || x <= 0) return 0;
+    *out = x;
+    return 1;
+}
+
+static int parse_options(int argc, char** argv, bench_options* opt) {
+    opt->format = "csv";
+    opt->out_path = NULL;
+    opt->compare_path = NULL;
+    opt->threshold = 5.0;
+    opt->reps = 31;
+    opt->max_bytes = (uint64_t)1 << 30;
+    opt->all_pairs = 0;
+    opt->quick = 0;
+    opt->replay_path = NULL;
+    int reps_set = 0, max_set = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(a, "--quick") == 0) {
+            opt->quick = 1;
+        } else if (strcmp(a, "--format") == 0 && v && (strcmp(v, "csv") == 0 || strcmp(v, "json") == 0)) {
+            opt->format = v;
+            i++;
+        } else if (strcmp(a, "--out") == 0 && v) {
+            opt->out_path = v;
+            i++;
+        } else if (strcmp(a, "--reps") == 0 && v && atoi(v) > 0) {
+            opt->reps = (unsigned)atoi(v);
+            reps_set = 1;
+            i++;
+        } else if (strcmp(a, "--max-bytes") == 0 && v && strtoull(v, NULL, 0) > 0) {
+            opt->max_bytes = strtoull(v, NULL, 0);
+            max_set = 1;
+            i++;
+        } else if (strcmp(a, "--pairs") == 0 && v && (strcmp(v, "all") == 0 || strcmp(v, "few") == 0)) {
+            opt->all_pairs = strcmp(v, "all") == 0 ? 1 : -1;
+            i++;
+        } else if (strcmp(a, "--compare") == 0 && v) {
+            opt->compare_path = v;
+            i++;
+        } else if (strcmp(a, "--threshold") == 0 && v && parse_positive(v, &opt->threshold)) {
+            i++;
+        } else if (strcmp(a, "--replay") == 0 && v) {
+            opt->replay_path = v;
+            i++;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (opt->quick) {
+        if (!reps_set) opt->reps = 11;
+        if (!max_set) opt->max_bytes = 1u << 20;
+        if (opt->all_pairs == 0) opt->all_pairs = -1;
+    }
+    return 0;
+}
+
+// 长度 × 位偏移扫描；返回回归数，失败返回 -1
+static int run_sweep(bench_options* opt, FILE* out, const baseline_entry* base, long nbase,
+                     const perf_counters* pc, unsigned* count) {
+    // 缓冲区按最大长度分配一次（+1 字节容纳位偏移），分配失败时减半
+    uint8_t* src = NULL;
+    uint8_t* dest = NULL;
+    while (opt->max_bytes >= 1024) {
+        src = (uint8_t*)malloc((size_t)opt->max_bytes + 1);
+        dest = (uint8_t*)malloc((size_t)opt->max_bytes + 1);
+        if (src && dest) break;
+        free(src);
+        free(dest);
+        src = dest = NULL;
+        opt->max_bytes >>= 1;
+        fprintf(stderr, "allocation failed, reducing --max-bytes to %llu\n", (unsigned long long)opt->max_bytes);
+    }
+    uint8_t* src_expanded = (uint8_t*)malloc(EXPANDED_MAX_BITS + 8);
+    uint8_t* dest_expanded = (uint8_t*)malloc(EXPANDED_MAX_BITS + 8);
+    if (!src || !dest || !src_expanded || !dest_expanded) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(src_expanded);
+        free(dest_expanded);
+        return -1;
+    }
+    for (uint64_t i = 0; i <= opt->max_bytes; i++) {
+        src[i] = (uint8_t)rand();
+        dest[i] = 0;  // 先写一遍，避免首次测量计入缺页
+    }
+    for (size_t i = 0; i < EXPANDED_MAX_BITS + 8; i++) {
+        src_expanded[i] = (uint8_t)(rand() & 1);
+        dest_expanded[i] = 0;
+    }
+
+    int regressions = 0;
+    for (size_t li = 0; li < sizeof(lengths) / sizeof(lengths[0]); li++) {
+        uint64_t len = lengths[li];
+        if (len > opt->max_bytes * 8) break;
+        int full = opt->all_pairs > 0 || (opt->all_pairs == 0 && len <= FULL_PAIRS_MAX_BITS);
+        unsigned npairs = full ? 64 : (unsigned)(sizeof(few_pairs) / sizeof(few_pairs[0]));
+        // 大块拷贝单次就要几十毫秒，减少重复次数
+        unsigned reps = opt->reps;
+        if (len >= ((uint64_t)1 << 29) && reps > 5) reps = 5;
+        fprintf(stderr, "len=%llu bits (%u offset pairs, %u reps)\n", (unsigned long long)len, npairs, reps);
+
+        for (size_t fi = 0; fi < sizeof(funcs) / sizeof(funcs[0]); fi++) {
+            const bench_func* f = &funcs[fi];
+            if (f->max_bits != 0 && len > f->max_bits) continue;
+            for (unsigned p = 0; p < (f->offsets ? npairs : 1); p++) {
+                unsigned sb = full ? p >> 3 : few_pairs[p][0];
+                unsigned db = full ? p & 7 : few_pairs[p][1];
+                bench_result r;
+                int ret;
+                if (f->expanded) {
+                    ret = measure(f, f->fn, dest_expanded, src_expanded, len, sb, db, reps, pc, &r);
+                } else {
+                    ret = measure(f, f->fn, dest, src, len, sb, db, reps, pc, &r);
+                }
+                if (ret != 0) {
+                    fprintf(stderr, "%s len=%llu: out of memory, skipped\n", f->name,
+                            (unsigned long long)len);
+                    continue;
+                }
+                write_result(out, opt->format, &r, *count == 0);
+                (*count)++;
+                if (base) {
+                    regressions += compare_result(&r, base, nbase, opt->threshold);
+                }
+            }
+        }
+        fflush(out);
+    }
+    free(src);
+    free(dest);
+    free(src_expanded);
+    free(dest_expanded);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    bench_options opt;
+    if (parse_options(argc, argv, &opt) != 0) return 2;
+
+    baseline_entry* baseline = NULL;
+    long nbase = 0;
+    if (opt.compare_path) {
+        nbase = load_baseline(opt.compare_path, &baseline);
+        if (nbase < 0) {
+            fprintf(stderr, "cannot read baseline %s\n", opt.compare_path);
+            return 2;
+        }
+    }
+
+    FILE* out = stdout;
+    if (opt.out_path) {
+        out = fopen(opt.out_path, "w");
+        if (!out) {
+            fprintf(stderr, "cannot open %s\n", opt.out_path);
+            return 2;
+        }
+    }
+    if (strcmp(opt.format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fputs(csv_header, out);
+    }
+
+    perf_counters pc;
+    perf_init(&pc);
+    if (pc.fd_cache < 0 && pc.fd_branch < 0) {
+        fprintf(stderr, "hardware counters unavailable, cache_misses/branch_misses reported as -1\n");
+    }
+
+    srand(12345);
+    unsigned count = 0;
+    int regressions = opt.replay_path ? run_replay(&opt, out, baseline, nbase, &pc, &count)
+                                      : run_sweep(&opt, out, baseline, nbase, &pc, &count);
+    if (strcmp(opt.format, "json") == 0) {
+        fprintf(out, "\n]\n");
+    }
+
+    perf_close(&pc);
+    if (out != stdout) fclose(out);
+    if (regressions >= 0) {
+        fprintf(stderr, "%u results", count);
+        if (baseline) {
+            fprintf(stderr, ", %d regressions over %.1f%% against %s", regressions, opt.threshold, opt.compare_path);
+        }
+        fprintf(stderr, "\n");
+    }
+    free(baseline);
+    return regressions < 0 ? 2 : regressions > 0 ? 1 : 0;
+}
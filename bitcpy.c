@@ -5,10 +5,349 @@ Email: Mhuixs.db@outlook.com
 */
 
 #include "bitcpy.h"
+#include "bitcpy_simd.h"
+
+/*
+ * === 阶段2 SIMD 内核 ===
+ * 源非对齐（src_bit != 0）时，阶段2每 64 位要做 8 字节 + 1 字节两次读取和一次移位拼接，
+ * 大块拷贝的时间几乎全部耗在这里。以下内核每步用 bitcpy_funnel_load*()（bitcpy_simd.h）处理 16/32/64 字节：
+ *   out = (load(src) >> src_bit) | (load(src + 1) << (8 - src_bit))   （按 64 位通道移位）
+ * 输出 n 字节只读取 src[0..n]，共 n + 1 字节；src_bit != 0 时调用者保证的可读字节数
+ * (src_bit + remaining + 7) / 8 >= remaining / 8 + 1，因此不会越界。
+ *
+ * 内核在首次调用时通过 CPUID 选定一次（AVX-512 VBMI2 > AVX-512 > AVX2 > SSE2），
+ * 之后通过函数指针直接调用；非 x86 平台或定义 BITCPY_NO_SIMD 时只使用标量循环。
+ * 内核返回已处理的字节数（向量宽度的整数倍），剩余部分交给原有的标量循环。
+ */
+#ifdef BITCPY_X86_SIMD
+
+// 少于该位数时直接走标量循环，避免间接调用的开销
+#define BITCPY_SIMD_MIN_BITS 256
+
+typedef size_t (*shr_kernel_fn)(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+
+__attribute__((target("sse2")))
+static size_t shr_kernel_sse2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(dest + i), bitcpy_funnel_load128(src + i, rs, ls));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t shr_kernel_avx2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i v0 = bitcpy_funnel_load256(src + i, rs, ls);
+        __m256i v1 = bitcpy_funnel_load256(src + i + 32, rs, ls);
+        _mm256_storeu_si256((__m256i*)(dest + i), v0);
+        _mm256_storeu_si256((__m256i*)(dest + i + 32), v1);
+    }
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256((__m256i*)(dest + i), bitcpy_funnel_load256(src + i, rs, ls));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t shr_kernel_avx512(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_si512((void*)(dest + i), bitcpy_funnel_load512(src + i, rs, ls));
+    }
+    return i;
+}
+
+// VBMI2 漏斗移位：每个 64 位通道与其后 8 字节拼成 128 位后右移，一条指令完成拼接。
+// 高半部分读取 src[i+8..i+71]，因此主循环要求 i + 71 <= n，剩余部分交给 AVX-512 循环。
+__attribute__((target("avx512f,avx512vbmi2")))
+static size_t shr_kernel_vbmi2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m512i cnt = _mm512_set1_epi64((long long)shift);
+    size_t i = 0;
+    for (; i + 71 <= n; i += 64) {
+        __m512i lo = _mm512_loadu_si512((const void*)(src + i));
+        __m512i hi = _mm512_loadu_si512((const void*)(src + i + 8));
+        _mm512_storeu_si512((void*)(dest + i), _mm512_shrdv_epi64(lo, hi, cnt));
+    }
+    return i + shr_kernel_avx512(dest + i, src + i, shift, n - i);
+}
+
+// 没有可用的 SIMD 指令集：不处理任何字节，全部交给标量循环
+static size_t shr_kernel_none(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    (void)dest; (void)src; (void)shift; (void)n;
+    return 0;
+}
+
+static size_t shr_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+static shr_kernel_fn shr_kernel = shr_kernel_resolve;
+
+// 首次调用时选择内核；多线程同时初始化只会写入相同的值
+static size_t shr_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    shr_kernel_fn fn = shr_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vbmi2")) {
+        fn = shr_kernel_vbmi2;
+    } else if (__builtin_cpu_supports("avx512f")) {
+        fn = shr_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = shr_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = shr_kernel_sse2;
+    }
+    shr_kernel = fn;
+    return fn(dest, src, shift, n);
+}
+#endif
+
+/*
+ * === 热路径统计 ===
+ * 每个线程第一次调用时分配一块计数器，无锁地压入全局链表，之后只通过线程局部指针访问。
+ * 拥有者线程用 relaxed 原子读写更新自己的计数器（在 x86 上就是普通的 load/add/store），
+ * 快照按字段原子读取后求和；计数器块在线程退出后保留，快照仍然包含它们。
+ */
+#ifdef BITCPY_STATS
+#include <stdlib.h>
+
+typedef struct stats_block {
+    bitcpy_stats s;
+    struct stats_block* next;
+} stats_block;
+
+static stats_block* stats_head = NULL;
+static stats_block stats_fallback;  // 分配失败的线程共用，计数可能不精确
+static __thread bitcpy_stats* stats_tls = NULL;
+
+static bitcpy_stats* stats_local_slow(void) {
+    stats_block* b = (stats_block*)calloc(1, sizeof(stats_block));
+    if (b == NULL) {
+        stats_tls = &stats_fallback.s;
+        return stats_tls;
+    }
+    b->next = __atomic_load_n(&stats_head, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&stats_head, &b->next, b, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    stats_tls = &b->s;
+    return stats_tls;
+}
+
+static inline bitcpy_stats* stats_local(void) {
+    bitcpy_stats* st = stats_tls;
+    return st != NULL ? st : stats_local_slow();
+}
+
+static inline void stats_add(uint64_t* c, uint64_t n) {
+    __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// bitcpy_stats 全部由 uint64_t 组成，快照和清零按字逐个处理
+#define STATS_WORDS (sizeof(bitcpy_stats) / sizeof(uint64_t))
+
+static void stats_accumulate(uint64_t* out, const bitcpy_stats* st) {
+    uint64_t* c = (uint64_t*)st;
+    for (size_t i = 0; i < STATS_WORDS; i++) {
+        out[i] += __atomic_load_n(&c[i], __ATOMIC_RELAXED);
+    }
+}
+
+static void stats_clear(bitcpy_stats* st) {
+    uint64_t* c = (uint64_t*)st;
+    for (size_t i = 0; i < STATS_WORDS; i++) {
+        __atomic_store_n(&c[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+int bitcpy_stats_snapshot(bitcpy_stats* out) {
+    memset(out, 0, sizeof(*out));
+    for (stats_block* b = __atomic_load_n(&stats_head, __ATOMIC_ACQUIRE); b != NULL; b = b->next) {
+        stats_accumulate((uint64_t*)out, &b->s);
+    }
+    stats_accumulate((uint64_t*)out, &stats_fallback.s);
+    return 1;
+}
+
+void bitcpy_stats_reset(void) {
+    for (stats_block* b = __atomic_load_n(&stats_head, __ATOMIC_ACQUIRE); b != NULL; b = b->next) {
+        stats_clear(&b->s);
+    }
+    stats_clear(&stats_fallback.s);
+}
+
+// len 直方图的桶号：floor(log2(len))，len >= 1
+static inline unsigned stats_len_bucket(uint64_t len) {
+#if defined(__GNUC__)
+    return 63u - (unsigned)__builtin_clzll(len);
+#else
+    unsigned b = 0;
+    while (len >>= 1) b++;
+    return b;
+#endif
+}
+
+#define STATS_DECL bitcpy_stats* st = stats_local()
+#define STATS_ADD(field, n) stats_add(&st->field, (uint64_t)(n))
+#else
+int bitcpy_stats_snapshot(bitcpy_stats* out) {
+    memset(out, 0, sizeof(*out));
+    return 0;
+}
+
+void bitcpy_stats_reset(void) {
+}
+
+#define STATS_DECL ((void)0)
+#define STATS_ADD(field, n) ((void)0)
+#endif
+
+/*
+ * === 调用记录 ===
+ * 每个线程第一次记录时分配一个缓冲区并压入全局链表（与统计计数器相同的方式），
+ * 记录只写入自己的缓冲区，满了才 fwrite 一整块：stdio 对同一个 FILE 的写入本身加锁。
+ * 每个缓冲区带一个自旋锁，记录和写出都在锁内进行，并在锁内重新检查 trace_active；
+ * 结束记录时先清除 trace_active，再逐个加锁写出所有线程的缓冲区，之后才关闭文件，
+ * 所以 atexit 时仍在调用 bitcpy() 的线程不会写入已关闭的文件。
+ */
+#ifdef BITCPY_TRACE
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_BUFFER_RECORDS 4096
+
+typedef struct trace_block {
+    uint64_t records[TRACE_BUFFER_RECORDS];
+    unsigned n;
+    int lock;  // 所属线程记录时和 bitcpy_trace_stop() 写出时持有
+    struct trace_block* next;
+} trace_block;
+
+static FILE* trace_file = NULL;
+static int trace_active = 0;
+static int trace_env_checked = 0;
+static trace_block* trace_head = NULL;
+static __thread trace_block* trace_tls = NULL;
+
+static inline void trace_lock(trace_block* b) {
+    while (__atomic_exchange_n(&b->lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&b->lock, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static inline void trace_unlock(trace_block* b) {
+    __atomic_store_n(&b->lock, 0, __ATOMIC_RELEASE);
+}
+
+// 调用者持有 b->lock
+static void trace_flush(trace_block* b) {
+    if (b->n != 0) {
+        FILE* f = __atomic_load_n(&trace_file, __ATOMIC_ACQUIRE);
+        if (f != NULL) fwrite(b->records, sizeof(uint64_t), b->n, f);
+        b->n = 0;
+    }
+}
+
+int bitcpy_trace_stop(void) {
+    FILE* f = __atomic_load_n(&trace_file, __ATOMIC_ACQUIRE);
+    if (f == NULL) return 0;
+    // trace_active 与 trace_head 都用 seq_cst：之后才压入链表的缓冲区，其线程在锁内一定看到 0；
+    // 逐个加锁写出，释放锁之后所属线程再加锁时也一定看到 0
+    __atomic_store_n(&trace_active, 0, __ATOMIC_SEQ_CST);
+    for (trace_block* b = __atomic_load_n(&trace_head, __ATOMIC_SEQ_CST); b != NULL; b = b->next) {
+        trace_lock(b);
+        trace_flush(b);
+        trace_unlock(b);
+    }
+    __atomic_store_n(&trace_file, NULL, __ATOMIC_RELEASE);
+    int err = ferror(f);
+    return (fclose(f) != 0 || err) ? -1 : 0;
+}
+
+int bitcpy_trace_start(const char* path) {
+    bitcpy_trace_stop();
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return -1;
+    if (fwrite(BITCPY_TRACE_MAGIC, 1, 8, f) != 8) {
+        fclose(f);
+        return -1;
+    }
+    __atomic_store_n(&trace_file, f, __ATOMIC_RELEASE);
+    __atomic_store_n(&trace_active, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static void trace_atexit(void) {
+    bitcpy_trace_stop();
+}
+
+// 只有第一个到达的线程检查环境变量；已经调用 bitcpy_trace_start() 时不覆盖调用者的记录
+static void trace_env_init(void) {
+    if (__atomic_exchange_n(&trace_env_checked, 1, __ATOMIC_ACQ_REL)) return;
+    if (__atomic_load_n(&trace_file, __ATOMIC_ACQUIRE) != NULL) return;
+    const char* path = getenv("BITCPY_TRACE_FILE");
+    if (path != NULL && path[0] != '\0' && bitcpy_trace_start(path) == 0) {
+        atexit(trace_atexit);
+    }
+}
+
+static trace_block* trace_local_slow(void) {
+    trace_block* b = (trace_block*)calloc(1, sizeof(trace_block));
+    if (b == NULL) return NULL;
+    b->next = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_head, &b->next, b, 1,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+    trace_tls = b;
+    return b;
+}
+
+static inline void trace_record(const uint8_t* dest, uint8_t dest_bit,
+                                const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (!__atomic_load_n(&trace_env_checked, __ATOMIC_RELAXED)) trace_env_init();
+    if (!__atomic_load_n(&trace_active, __ATOMIC_RELAXED)) return;
+    trace_block* b = trace_tls;
+    if (b == NULL && (b = trace_local_slow()) == NULL) return;
+    bitcpy_trace_call c = {len, dest_bit, src_bit,
+                           (uint8_t)((uintptr_t)dest & 63), (uint8_t)((uintptr_t)src & 63)};
+    trace_lock(b);
+    if (__atomic_load_n(&trace_active, __ATOMIC_SEQ_CST)) {
+        b->records[b->n++] = bitcpy_trace_encode(&c);
+        if (b->n == TRACE_BUFFER_RECORDS) trace_flush(b);
+    }
+    trace_unlock(b);
+}
+
+#define TRACE_RECORD(dest, dest_bit, src, src_bit, len) trace_record(dest, dest_bit, src, src_bit, len)
+#else
+int bitcpy_trace_start(const char* path) {
+    (void)path;
+    return -1;
+}
+
+int bitcpy_trace_stop(void) {
+    return 0;
+}
+
+#define TRACE_RECORD(dest, dest_bit, src, src_bit, len) ((void)0)
+#endif
 
 void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,uint64_t len){    
+    TRACE_RECORD(dest, dest_bit, src, src_bit, len);
     if (len == 0) return;
+    STATS_DECL;
+    STATS_ADD(calls, 1);
+    STATS_ADD(bits, len);
+    STATS_ADD(len_hist[stats_len_bucket(len)], 1);
+    STATS_ADD(offset_hist[src_bit & 7][dest_bit & 7], 1);
     if ((src_bit | dest_bit) == 0 && (len & 7) == 0) {
+        STATS_ADD(fast_path, 1);
+        STATS_ADD(fast_path_bits, len);
         memcpy(dest, src, len >> 3);
         return;
     }
@@ -20,6 +359,8 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
     if (dest_bit != 0) {
         uint8_t align_bits = 8 - dest_bit;
         if (align_bits > remaining) align_bits = (uint8_t)remaining;
+        STATS_ADD(phase1, 1);
+        STATS_ADD(phase1_bits, align_bits);
         
         // 提取源数据（可能跨字节）
         uint16_t src_data = src[0];
@@ -49,6 +390,22 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
     // 64位块需要读取8字节（对齐）或9字节（非对齐）
     
     // 阶段2：64位块处理
+#ifdef BITCPY_X86_SIMD
+    // 源非对齐的大块数据先交给 SIMD 内核，剩余不足一个向量的部分继续走下面的标量循环
+    if (src_bit != 0 && remaining >= BITCPY_SIMD_MIN_BITS) {
+        size_t done = shr_kernel(dest, src, src_bit, (size_t)(remaining >> 3));
+        STATS_ADD(simd_calls, 1);
+        STATS_ADD(simd_bits, (uint64_t)done << 3);
+        dest += done;
+        src += done;
+        remaining -= (uint64_t)done << 3;
+    }
+#endif
+    // 迭代次数在进入循环前就能确定：源非对齐时剩余恰好为 64 的倍数会少一次，并在最后一次 break
+    if (remaining >= 64) {
+        STATS_ADD(block64, src_bit == 0 ? remaining >> 6 : (remaining - 1) >> 6);
+        STATS_ADD(block64_break, src_bit != 0 && (remaining & 63) == 0);
+    }
     while (remaining >= 64) {
         uint64_t data;
         if (src_bit == 0) {
@@ -77,6 +434,7 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
     }
     
     // 阶段3：字节级处理
+    STATS_ADD(byte_iters, remaining >> 3);
     while (remaining >= 8) {
         uint8_t data;
         if (src_bit == 0) {
@@ -100,6 +458,8 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
     
     // 阶段4：处理剩余位（1-7位）
     if (remaining > 0) {
+        STATS_ADD(tail, 1);
+        STATS_ADD(tail_bits, remaining);
         // 提取源数据
         uint16_t src_data = src[0];
         if (src_bit + remaining > 8) {
@@ -113,3 +473,685 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
         dest[0] = (dest[0] & mask_high[remaining]) | (uint8_t)src_data;
     }
 }
+
+/*
+ * === 带填充的拷贝 ===
+ * 目标按 64 位字划分：第 k 个字（dest + 8k）的第 j 位来自源的第 src_bit - dest_bit + 64k + j 位，
+ * 所以每个字都是源上同一移位量 (src_bit - dest_bit) & 7 的一次 8 字节 + 1 字节拼接。
+ * 首字和末字带掩码读-改-写，中间的字整字写入；没有阶段1、阶段3和阶段4。
+ * 末字最多读到源区间末字节之后 8 字节，写回目标区间末字节之后 7 字节（写回原值）。
+ */
+#define PADDED_MAX_BITS 1024  // 超过该位数时交给 bitcpy()，使用阶段2的 SIMD 内核
+
+static inline uint64_t load_u64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline void store_u64_masked(uint8_t* p, uint64_t v, uint64_t mask) {
+    uint64_t w = load_u64(p);
+    w = (w & ~mask) | (v & mask);
+    memcpy(p, &w, 8);
+}
+
+// 从 p 的第 shift 位（0-7）开始取 64 位；shift != 0 时读取 9 字节
+static inline uint64_t load_shifted(const uint8_t* p, unsigned shift) {
+    uint64_t v = load_u64(p);
+    return shift == 0 ? v : (v >> shift) | ((uint64_t)p[8] << (64 - shift));
+}
+
+void bitcpy_padded(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    if (len > PADDED_MAX_BITS) {
+        bitcpy(dest, dest_bit, src, src_bit, len);
+        return;
+    }
+    uint64_t end = dest_bit + len;  // 相对 dest 第 0 位的结束位置
+    uint64_t nwords = (end + 63) >> 6;
+    uint64_t head_mask = ~(uint64_t)0 << dest_bit;
+    uint64_t tail_mask = (end & 63) ? ((uint64_t)1 << (end & 63)) - 1 : ~(uint64_t)0;
+
+    // 首字：源起点比目标靠前时，dest_bit 以下的位来自 src 之前，被掩码丢弃，只需左移
+    uint64_t first = src_bit >= dest_bit ? load_shifted(src, src_bit - dest_bit)
+                                         : load_u64(src) << (dest_bit - src_bit);
+    if (nwords == 1) {
+        store_u64_masked(dest, first, head_mask & tail_mask);
+        return;
+    }
+    store_u64_masked(dest, first, head_mask);
+
+    // 第 k 个字（k >= 1）从源字节 8k + (src_bit - dest_bit) / 8（向下取整）的第 shift 位开始
+    int delta = (int)src_bit - (int)dest_bit;
+    unsigned shift = (unsigned)delta & 7;
+    const uint8_t* s = src + 8 + (delta < 0 ? -1 : 0);
+    uint8_t* d = dest + 8;
+    for (uint64_t k = 1; k + 1 < nwords; k++) {
+        uint64_t v = load_shifted(s, shift);
+        memcpy(d, &v, 8);
+        s += 8;
+        d += 8;
+    }
+    store_u64_masked(d, load_shifted(s, shift), tail_mask);
+}
+
+// 拷贝 n 位（1-8）到单个目标字节内，要求 dest_bit + n <= 8；源数据可能跨两个字节
+static inline void copy_bits_in_byte(uint8_t* dest, uint8_t dest_bit,
+                                     const uint8_t* src, uint8_t src_bit, uint8_t n) {
+    uint16_t src_data = src[0];
+    if (src_bit + n > 8) {
+        src_data |= (uint16_t)src[1] << 8;
+    }
+    uint8_t write_mask = (uint8_t)(((1u << n) - 1) << dest_bit);
+    dest[0] = (uint8_t)((dest[0] & ~write_mask) |
+                        (((unsigned)(src_data >> src_bit) << dest_bit) & write_mask));
+}
+
+// 反向拷贝：按地址从高到低执行阶段1-4，目标位地址高于源且区间重叠时使用
+static void bitcpy_backward(uint8_t* dest, uint8_t dest_bit,
+                            const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    uint64_t remaining = len;
+    uint64_t dest_end = dest_bit + len;  // 相对 dest 的结束位（不含）
+    uint64_t src_end = src_bit + len;    // 相对 src 的结束位（不含）
+    
+    // 阶段1：处理末尾位，使目标结束位置对齐到字节边界
+    uint8_t tail = dest_end & 7;
+    if (tail != 0) {
+        uint8_t n = tail < remaining ? tail : (uint8_t)remaining;
+        dest_end -= n;
+        src_end -= n;
+        copy_bits_in_byte(dest + (dest_end >> 3), dest_end & 7,
+                          src + (src_end >> 3), src_end & 7, n);
+        remaining -= n;
+        if (remaining == 0) return;
+    }
+    
+    // 此时 d 指向已对齐的目标结束位置，s/shift 描述源结束位置
+    uint8_t* d = dest + (dest_end >> 3);
+    const uint8_t* s = src + (src_end >> 3);
+    uint8_t shift = src_end & 7;
+    
+    // 阶段2：64位块处理，从高地址向低地址
+    // 目标位地址高于源地址，所以 d > s：写入 d[0..7] 不会破坏下一块要读的 s[-8..0]
+    // 反向时源数据的最高字节 s[8] 总在有效范围内，不需要像正向那样在最后一块退回字节处理
+    while (remaining >= 64) {
+        uint64_t data;
+        d -= 8;
+        s -= 8;
+        if (shift == 0) {
+            memcpy(&data, s, 8);
+        } else {
+            uint64_t part1;
+            memcpy(&part1, s, 8);
+            data = (part1 >> shift) | ((uint64_t)s[8] << (64 - shift));
+        }
+        memcpy(d, &data, 8);
+        remaining -= 64;
+    }
+    
+    // 阶段3：字节级处理
+    while (remaining >= 8) {
+        d--;
+        s--;
+        if (shift == 0) {
+            *d = s[0];
+        } else {
+            *d = (uint8_t)((s[0] >> shift) | (s[1] << (8 - shift)));
+        }
+        remaining -= 8;
+    }
+    
+    // 阶段4：剩余的前导位（1-7位），与目标起始位同处 dest[0]
+    if (remaining > 0) {
+        copy_bits_in_byte(dest, dest_bit, src, src_bit, (uint8_t)remaining);
+    }
+}
+
+void bitmove(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    // 快速路径：字节对齐时交给 memmove（bitcpy 的 memcpy 快速路径不允许重叠）
+    if ((src_bit | dest_bit) == 0 && (len & 7) == 0) {
+        memmove(dest, src, len >> 3);
+        return;
+    }
+    
+    // 目标位地址不高于源位地址时，正向拷贝每一步都先读后写，且只覆盖已读过的源位
+    if ((uintptr_t)dest < (uintptr_t)src || (dest == src && dest_bit <= src_bit)) {
+        if (dest != src || dest_bit != src_bit) {
+            bitcpy(dest, dest_bit, src, src_bit, len);
+        }
+        return;
+    }
+    
+    // 目标位地址高于源位地址：只有两区间重叠时才需要反向拷贝
+    uint64_t gap = ((uint64_t)((uintptr_t)dest - (uintptr_t)src) << 3) + dest_bit - src_bit;
+    if (gap >= len) {
+        bitcpy(dest, dest_bit, src, src_bit, len);
+    } else {
+        bitcpy_backward(dest, dest_bit, src, src_bit, len);
+    }
+}
+
+/*
+ * === 位向量的插入与删除 ===
+ * 都只移动 pos 之后的尾部一次：插入时尾部向高地址移动，目标高于源且重叠，bitmove() 走反向的阶段1-4；
+ * 删除时尾部向低地址移动，bitmove() 直接正向调用 bitcpy()，源非对齐时使用阶段2的 SIMD 内核。
+ * 两个方向都是 64 位块移位拼接，不分配临时缓冲区。
+ */
+void bitinsert(uint8_t* buf, uint64_t used, uint64_t pos,
+               const uint8_t* src, uint8_t src_bit, uint64_t k) {
+    if (k == 0) return;
+    uint64_t to = pos + k;
+    bitmove(buf + (to >> 3), (uint8_t)(to & 7), buf + (pos >> 3), (uint8_t)(pos & 7), used - pos);
+    if (src != NULL) {
+        bitcpy(buf + (pos >> 3), (uint8_t)(pos & 7), src, src_bit, k);
+    } else {
+        bitfill(buf + (pos >> 3), (uint8_t)(pos & 7), k, 0);
+    }
+}
+
+void bitdelete(uint8_t* buf, uint64_t used, uint64_t pos, uint64_t k) {
+    uint64_t from = pos + k;
+    if (k == 0 || from >= used) return;
+    bitmove(buf + (pos >> 3), (uint8_t)(pos & 7), buf + (from >> 3), (uint8_t)(from & 7), used - from);
+}
+
+/*
+ * === 批量拷贝 ===
+ * 描述符按窗口（最多 BATCH_WINDOW 个）用计数排序分到 64 个 (src_bit, dest_bit) 类中，
+ * 同一类内移位量和掩码是循环不变量，分支也都可预测。短拷贝每步用一次 8 字节
+ * 读-改-写处理 56 位（正好 7 字节，所以 src_bit/dest_bit 每步不变），最后一步只读写
+ * 实际覆盖的字节；长拷贝直接交给 bitcpy() 以使用阶段2的 SIMD 内核。
+ */
+#define BATCH_WINDOW 1024
+#define BATCH_LONG_BITS 512
+#define BATCH_PREFETCH_DISTANCE 8
+
+// 读取 n 字节（1-8）为小端 64 位整数，不越过 p[n-1]
+static inline uint64_t load_partial(const uint8_t* p, unsigned n) {
+    if (n >= 4) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + n - 4, 4);  // 与 lo 重叠的字节值相同，按位或不影响结果
+        return lo | ((uint64_t)hi << ((n - 4) * 8));
+    }
+    return (uint64_t)p[0] | ((uint64_t)p[n >> 1] << ((n >> 1) * 8)) |
+           ((uint64_t)p[n - 1] << ((n - 1) * 8));
+}
+
+// 写入 v 的低 n 字节（1-8），不越过 p[n-1]
+static inline void store_partial(uint8_t* p, unsigned n, uint64_t v) {
+    if (n >= 4) {
+        uint32_t lo = (uint32_t)v;
+        uint32_t hi = (uint32_t)(v >> ((n - 4) * 8));
+        memcpy(p + n - 4, &hi, 4);
+        memcpy(p, &lo, 4);
+        return;
+    }
+    p[n - 1] = (uint8_t)(v >> ((n - 1) * 8));
+    p[n >> 1] = (uint8_t)(v >> ((n >> 1) * 8));
+    p[0] = (uint8_t)v;
+}
+
+// 单个短描述符：src_bit/dest_bit 由调用者固定，body_mask = 56 位掩码 << dest_bit
+static inline void batch_copy_short(uint8_t* dest, unsigned dest_bit,
+                                    const uint8_t* src, unsigned src_bit,
+                                    uint64_t body_mask, uint64_t len) {
+    // 剩余 > 56 位时源和目标都至少还有 8 个有效字节，可以整字读写
+    while (len > 56) {
+        uint64_t v, w;
+        memcpy(&v, src, 8);
+        memcpy(&w, dest, 8);
+        w = (w & ~body_mask) | (((v >> src_bit) << dest_bit) & body_mask);
+        memcpy(dest, &w, 8);
+        dest += 7;
+        src += 7;
+        len -= 56;
+    }
+    // 最后 1-56 位
+    unsigned src_bytes = (unsigned)((src_bit + len + 7) >> 3);
+    unsigned dest_bytes = (unsigned)((dest_bit + len + 7) >> 3);
+    uint64_t mask = (((uint64_t)1 << len) - 1) << dest_bit;
+    uint64_t v = load_partial(src, src_bytes) >> src_bit;
+    uint64_t w = load_partial(dest, dest_bytes);
+    store_partial(dest, dest_bytes, (w & ~mask) | ((v << dest_bit) & mask));
+}
+
+void bitcpy_batch(const bitcpy_desc* descs, size_t n) {
+    uint16_t order[BATCH_WINDOW];
+    uint16_t start[65];
+    
+    for (size_t base = 0; base < n; base += BATCH_WINDOW) {
+        const bitcpy_desc* win = descs + base;
+        unsigned count = (unsigned)(n - base < BATCH_WINDOW ? n - base : BATCH_WINDOW);
+        
+        // 计数排序：按类 (src_bit << 3 | dest_bit) 分组，组内保持原顺序
+        memset(start, 0, sizeof(start));
+        for (unsigned i = 0; i < count; i++) {
+            start[((win[i].src_bit << 3) | win[i].dest_bit) + 1]++;
+        }
+        for (unsigned c = 0; c < 64; c++) {
+            start[c + 1] += start[c];
+        }
+        uint16_t pos[64];
+        memcpy(pos, start, sizeof(pos));
+        for (unsigned i = 0; i < count; i++) {
+            order[pos[(win[i].src_bit << 3) | win[i].dest_bit]++] = (uint16_t)i;
+        }
+        
+        // 逐类处理，移位量和掩码在类内不变；预取排序后靠后的描述符的数据
+        for (unsigned c = 0; c < 64; c++) {
+            unsigned src_bit = c >> 3;
+            unsigned dest_bit = c & 7;
+            uint64_t body_mask = (((uint64_t)1 << 56) - 1) << dest_bit;
+            for (unsigned k = start[c]; k < start[c + 1]; k++) {
+                if (k + BATCH_PREFETCH_DISTANCE < count) {
+                    const bitcpy_desc* ahead = &win[order[k + BATCH_PREFETCH_DISTANCE]];
+                    BITCPY_PREFETCH(ahead->src, 0);
+                    BITCPY_PREFETCH(ahead->dest, 1);
+                }
+                const bitcpy_desc* d = &win[order[k]];
+                if (d->len == 0) continue;
+                if (d->len > BATCH_LONG_BITS) {
+                    bitcpy(d->dest, d->dest_bit, d->src, d->src_bit, d->len);
+                } else {
+                    batch_copy_short(d->dest, dest_bit, d->src, src_bit, body_mask, d->len);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * === 流式拷贝 ===
+ * 目标按 64 字节缓存行对齐后，主体部分用非临时存储（MOVNTDQ）直接写入内存，不占用缓存；
+ * 源数据用 PREFETCHNTA 提前预取。首尾不足一个缓存行的部分仍由 bitcpy() 处理。
+ * 移位拼接方式与阶段2 SIMD 内核相同；src_bit == 0 时只做一次读取。
+ */
+#define STREAM_MIN_BITS 8192            // 少于 1 KiB 时非临时存储没有意义
+#define STREAM_PREFETCH_DISTANCE 512    // 源预取距离（字节）
+
+#ifdef BITCPY_X86_SIMD
+typedef void (*stream_kernel_fn)(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+
+// 以下内核要求 dest 按 64 字节对齐、n 是 64 的倍数
+__attribute__((target("sse2")))
+static void stream_kernel_sse2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    for (size_t i = 0; i < n; i += 16) {
+        if ((i & 63) == 0) {
+            _mm_prefetch((const char*)(src + i + STREAM_PREFETCH_DISTANCE), _MM_HINT_NTA);
+        }
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        if (shift != 0) {
+            __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 1));
+            v = _mm_or_si128(_mm_srl_epi64(v, rs), _mm_sll_epi64(hi, ls));
+        }
+        _mm_stream_si128((__m128i*)(dest + i), v);
+    }
+}
+
+__attribute__((target("avx2")))
+static void stream_kernel_avx2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    for (size_t i = 0; i < n; i += 64) {
+        _mm_prefetch((const char*)(src + i + STREAM_PREFETCH_DISTANCE), _MM_HINT_NTA);
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        if (shift != 0) {
+            __m256i hi0 = _mm256_loadu_si256((const __m256i*)(src + i + 1));
+            __m256i hi1 = _mm256_loadu_si256((const __m256i*)(src + i + 33));
+            v0 = _mm256_or_si256(_mm256_srl_epi64(v0, rs), _mm256_sll_epi64(hi0, ls));
+            v1 = _mm256_or_si256(_mm256_srl_epi64(v1, rs), _mm256_sll_epi64(hi1, ls));
+        }
+        _mm256_stream_si256((__m256i*)(dest + i), v0);
+        _mm256_stream_si256((__m256i*)(dest + i + 32), v1);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void stream_kernel_avx512(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)shift);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - shift));
+    for (size_t i = 0; i < n; i += 64) {
+        _mm_prefetch((const char*)(src + i + STREAM_PREFETCH_DISTANCE), _MM_HINT_NTA);
+        __m512i v = _mm512_loadu_si512((const void*)(src + i));
+        if (shift != 0) {
+            __m512i hi = _mm512_loadu_si512((const void*)(src + i + 1));
+            v = _mm512_or_si512(_mm512_srl_epi64(v, rs), _mm512_sll_epi64(hi, ls));
+        }
+        _mm512_stream_si512((void*)(dest + i), v);
+    }
+}
+
+static void stream_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+static stream_kernel_fn stream_kernel = stream_kernel_resolve;
+
+// 首次调用时选择内核；x86 上 SSE2 总是可用（32 位平台没有 SSE2 时不会走到这里）
+static void stream_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    stream_kernel_fn fn = stream_kernel_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        fn = stream_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = stream_kernel_avx2;
+    }
+    stream_kernel = fn;
+    fn(dest, src, shift, n);
+}
+#endif
+
+void bitcpy_stream(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+#ifdef BITCPY_X86_SIMD
+#if defined(__i386__)
+    if (!__builtin_cpu_supports("sse2")) {
+        bitcpy(dest, dest_bit, src, src_bit, len);
+        return;
+    }
+#endif
+    if (len < STREAM_MIN_BITS) {
+        bitcpy(dest, dest_bit, src, src_bit, len);
+        return;
+    }
+    
+    // 首部：普通拷贝到目标的下一个 64 字节边界
+    uint64_t head = ((64 - ((uintptr_t)dest & 63)) & 63) << 3;
+    if (head < dest_bit) {
+        head += 512;  // dest 本身已对齐但 dest_bit != 0：对齐到下一个缓存行
+    }
+    head -= dest_bit;
+    bitcpy(dest, dest_bit, src, src_bit, head);
+    uint64_t src_pos = src_bit + head;
+    dest += (dest_bit + head) >> 3;
+    src += src_pos >> 3;
+    src_bit = src_pos & 7;
+    len -= head;
+    
+    // 主体：整缓存行的非临时存储；src_bit != 0 时输出 n 字节读取 src[0..n]，不会越界
+    size_t body = (size_t)(len >> 9) << 6;
+    stream_kernel(dest, src, src_bit, body);
+    _mm_sfence();  // 非临时存储是弱序的，返回前保证对其他线程可见
+    
+    // 尾部
+    bitcpy(dest + body, 0, src + body, src_bit, len - ((uint64_t)body << 3));
+#else
+    bitcpy(dest, dest_bit, src, src_bit, len);
+#endif
+}
+
+/*
+ * === 位填充 ===
+ * 首尾字节带掩码读-改-写，中间整字节交给 memset；很长的区间改用非临时存储，
+ * 避免清空大位图时把调用者的热数据挤出缓存。
+ */
+#define FILL_STREAM_MIN_BYTES (4u << 20)  // 不小于该字节数时使用非临时存储
+
+#ifdef BITCPY_X86_SIMD
+typedef void (*fill_kernel_fn)(uint8_t* dest, uint8_t byte, size_t n);
+
+// 以下内核要求 dest 按 64 字节对齐、n 是 64 的倍数
+__attribute__((target("sse2")))
+static void fill_kernel_sse2(uint8_t* dest, uint8_t byte, size_t n) {
+    const __m128i v = _mm_set1_epi8((char)byte);
+    for (size_t i = 0; i < n; i += 64) {
+        _mm_stream_si128((__m128i*)(dest + i), v);
+        _mm_stream_si128((__m128i*)(dest + i + 16), v);
+        _mm_stream_si128((__m128i*)(dest + i + 32), v);
+        _mm_stream_si128((__m128i*)(dest + i + 48), v);
+    }
+}
+
+__attribute__((target("avx2")))
+static void fill_kernel_avx2(uint8_t* dest, uint8_t byte, size_t n) {
+    const __m256i v = _mm256_set1_epi8((char)byte);
+    for (size_t i = 0; i < n; i += 64) {
+        _mm256_stream_si256((__m256i*)(dest + i), v);
+        _mm256_stream_si256((__m256i*)(dest + i + 32), v);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void fill_kernel_avx512(uint8_t* dest, uint8_t byte, size_t n) {
+    const __m512i v = _mm512_set1_epi32((int)(0x01010101u * byte));
+    for (size_t i = 0; i < n; i += 64) {
+        _mm512_stream_si512((void*)(dest + i), v);
+    }
+}
+
+static void fill_kernel_resolve(uint8_t* dest, uint8_t byte, size_t n);
+static fill_kernel_fn fill_kernel = fill_kernel_resolve;
+
+// 首次调用时选择内核；x86 上 SSE2 总是可用（32 位平台没有 SSE2 时不会走到这里）
+static void fill_kernel_resolve(uint8_t* dest, uint8_t byte, size_t n) {
+    fill_kernel_fn fn = fill_kernel_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        fn = fill_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = fill_kernel_avx2;
+    }
+    fill_kernel = fn;
+    fn(dest, byte, n);
+}
+#endif
+
+void bitfill(uint8_t* dest, uint8_t dest_bit, uint64_t len, int value) {
+    if (len == 0) return;
+    uint8_t byte = value ? 0xFF : 0x00;
+    
+    // 首字节：dest_bit 之后的 1-8 位
+    if (dest_bit != 0) {
+        unsigned n = 8 - dest_bit;
+        if (n > len) n = (unsigned)len;
+        uint8_t mask = (uint8_t)(((1u << n) - 1) << dest_bit);
+        dest[0] = (uint8_t)((dest[0] & ~mask) | (byte & mask));
+        len -= n;
+        dest++;
+    }
+    
+    // 中间整字节
+    size_t bytes = (size_t)(len >> 3);
+#ifdef BITCPY_X86_SIMD
+    if (bytes >= FILL_STREAM_MIN_BYTES
+#if defined(__i386__)
+        && __builtin_cpu_supports("sse2")
+#endif
+    ) {
+        // 普通写入到 64 字节边界，整缓存行用非临时存储，剩余部分交给下面的 memset
+        size_t head = (64 - ((uintptr_t)dest & 63)) & 63;
+        memset(dest, byte, head);
+        size_t body = (bytes - head) & ~(size_t)63;
+        fill_kernel(dest + head, byte, body);
+        _mm_sfence();  // 非临时存储是弱序的，返回前保证对其他线程可见
+        dest += head + body;
+        bytes -= head + body;
+    }
+#endif
+    memset(dest, byte, bytes);
+    
+    // 末字节：剩余 1-7 位
+    if ((len & 7) != 0) {
+        uint8_t mask = (uint8_t)((1u << (len & 7)) - 1);
+        dest[bytes] = (uint8_t)((dest[bytes] & ~mask) | (byte & mask));
+    }
+}
+
+/*
+ * === MSB 优先位序 ===
+ * 位 0 是字节的最高有效位，位序号递增时从高位走向低位，再进入下一字节。
+ * 阶段划分与 bitcpy() 相同，移位方向相反：64 位块按大端序读写（相当于字节交换后的整字），
+ * 源非对齐时 out = (load_be(src) << src_bit) | (src[8] >> (8 - src_bit))。
+ */
+static inline uint64_t load_be64(const uint8_t* p) {
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+           ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static inline void store_be64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+#ifdef BITCPY_X86_SIMD
+/*
+ * MSB 阶段2内核：每个输出字节 out[i] = (src[i] << shift) | (src[i+1] >> (8 - shift))。
+ * x86 没有字节移位指令，用 16 位通道移位后按字节掩码去掉跨字节移入的位。
+ * 与 LSB 内核相同，输出 n 字节读取 src[0..n]。
+ */
+typedef size_t (*shl_kernel_fn)(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+
+__attribute__((target("sse2")))
+static size_t shl_kernel_sse2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i ls = _mm_cvtsi32_si128((int)shift);
+    const __m128i rs = _mm_cvtsi32_si128((int)(8 - shift));
+    const __m128i hi_mask = _mm_set1_epi8((char)(0xFF << shift));
+    const __m128i lo_mask = _mm_set1_epi8((char)(0xFF >> (8 - shift)));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 1));
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_or_si128(_mm_and_si128(_mm_sll_epi16(a, ls), hi_mask),
+                                      _mm_and_si128(_mm_srl_epi16(b, rs), lo_mask)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t shl_kernel_avx2(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i ls = _mm_cvtsi32_si128((int)shift);
+    const __m128i rs = _mm_cvtsi32_si128((int)(8 - shift));
+    const __m256i hi_mask = _mm256_set1_epi8((char)(0xFF << shift));
+    const __m256i lo_mask = _mm256_set1_epi8((char)(0xFF >> (8 - shift)));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 1));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi16(a, ls), hi_mask),
+                                            _mm256_and_si256(_mm256_srl_epi16(b, rs), lo_mask)));
+    }
+    return i;
+}
+
+// 按位选择合并两部分：VPTERNLOGQ 0xCA = mask ? a : b，两部分各自只取 hi_mask 内外的位
+__attribute__((target("avx512f,avx512bw")))
+static size_t shl_kernel_avx512(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    const __m128i ls = _mm_cvtsi32_si128((int)shift);
+    const __m128i rs = _mm_cvtsi32_si128((int)(8 - shift));
+    const __m512i hi_mask = _mm512_set1_epi8((char)(0xFF << shift));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i a = _mm512_loadu_si512((const void*)(src + i));
+        __m512i b = _mm512_loadu_si512((const void*)(src + i + 1));
+        _mm512_storeu_si512((void*)(dest + i),
+                            _mm512_ternarylogic_epi64(hi_mask, _mm512_sll_epi16(a, ls),
+                                                      _mm512_srl_epi16(b, rs), 0xCA));
+    }
+    return i;
+}
+
+static size_t shl_kernel_none(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    (void)dest; (void)src; (void)shift; (void)n;
+    return 0;
+}
+
+static size_t shl_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n);
+static shl_kernel_fn shl_kernel = shl_kernel_resolve;
+
+// 首次调用时选择内核；多线程同时初始化只会写入相同的值
+static size_t shl_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned shift, size_t n) {
+    shl_kernel_fn fn = shl_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        fn = shl_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = shl_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = shl_kernel_sse2;
+    }
+    shl_kernel = fn;
+    return fn(dest, src, shift, n);
+}
+#endif
+
+void bitcpy_msb(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    if ((src_bit | dest_bit) == 0 && (len & 7) == 0) {
+        memcpy(dest, src, len >> 3);
+        return;
+    }
+    uint64_t remaining = len;
+    
+    // 阶段1：处理前导位，使目标对齐到字节边界
+    if (dest_bit != 0) {
+        unsigned n = 8 - dest_bit;
+        if (n > remaining) n = (unsigned)remaining;
+        
+        // 源数据左对齐到 16 位的高端，取最高 n 位
+        uint16_t src_data = (uint16_t)(src[0] << 8);
+        if (src_bit + n > 8) {
+            src_data |= src[1];
+        }
+        uint8_t bits = (uint8_t)((uint16_t)(src_data << src_bit) >> (16 - n));
+        unsigned shift = 8 - dest_bit - n;
+        uint8_t write_mask = (uint8_t)(((1u << n) - 1) << shift);
+        dest[0] = (uint8_t)((dest[0] & ~write_mask) | (bits << shift));
+        
+        remaining -= n;
+        if (remaining == 0) return;
+        dest++;
+        src += (src_bit + n) >> 3;
+        src_bit = (src_bit + n) & 7;
+    }
+    
+    // 阶段2：64位块处理
+#ifdef BITCPY_X86_SIMD
+    if (src_bit != 0 && remaining >= BITCPY_SIMD_MIN_BITS) {
+        size_t done = shl_kernel(dest, src, src_bit, (size_t)(remaining >> 3));
+        dest += done;
+        src += done;
+        remaining -= (uint64_t)done << 3;
+    }
+#endif
+    while (remaining >= 64) {
+        if (src_bit == 0) {
+            memcpy(dest, src, 8);
+        } else {
+            // 需要读取 9 字节，刚好剩 64 位时退回字节处理（与 bitcpy() 相同）
+            if (remaining == 64) break;
+            store_be64(dest, (load_be64(src) << src_bit) | (src[8] >> (8 - src_bit)));
+        }
+        dest += 8;
+        src += 8;
+        remaining -= 64;
+    }
+    
+    // 阶段3：字节级处理
+    while (remaining >= 8) {
+        if (src_bit == 0) {
+            *dest = *src;
+        } else {
+            *dest = (uint8_t)((src[0] << src_bit) | (src[1] >> (8 - src_bit)));
+        }
+        dest++;
+        src++;
+        remaining -= 8;
+    }
+    
+    // 阶段4：剩余位（1-7位），写入目标字节的高位，保留低位
+    if (remaining > 0) {
+        uint16_t src_data = (uint16_t)(src[0] << 8);
+        if (src_bit + remaining > 8) {
+            src_data |= src[1];
+        }
+        uint8_t write_mask = (uint8_t)(0xFF << (8 - remaining));
+        uint8_t bits = (uint8_t)((uint16_t)(src_data << src_bit) >> 8);
+        dest[0] = (uint8_t)((dest[0] & ~write_mask) | (bits & write_mask));
+    }
+}
@@ -4,6 +4,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief 位级别内存拷贝
  * @param dest      目标缓冲区（指向起始字节），必须非 NULL
@@ -20,7 +24,9 @@
  * - len 必须 >= 0
  * - dest 缓冲区至少需要 (dest_bit + len + 7) / 8 字节
  * - src 缓冲区至少需要 (src_bit + len + 7) / 8 字节
- * - 当 len > 0 时，dest 和 src 可以指向同一内存区域（支持自拷贝）
+ * - 当 len > 0 时，dest 和 src 可以指向同一内存区域（支持自拷贝），
+ *   但各阶段都是正向拷贝：只有目标位地址不高于源位地址、或两区间不重叠时结果才正确，
+ *   向高地址的重叠拷贝请使用 bitmove()
  *
  * === 未定义行为 ===
  * 如果违反以下任何条件，行为未定义：
@@ -59,6 +65,9 @@
  *    - 实现：
  *      - 如果 src_bit == 0：直接 memcpy 8字节
  *      - 如果 src_bit != 0：读取9字节拼接成64位（需保证剩余 > 64）
+ *      - 如果 src_bit != 0 且剩余 >= 256 位：先由 SIMD 内核每步移位拼接 16/32/64 字节，
+ *        内核在首次调用时按 CPUID 选定（AVX-512 VBMI2 > AVX-512 > AVX2 > SSE2），
+ *        不足一个向量的部分继续走上面的64位循环；定义 BITCPY_NO_SIMD 可关闭
  *    - 优势：最大化内存带宽利用率
  *
  * 4. 阶段3：字节级处理
@@ -83,5 +92,282 @@
  */
 void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,uint64_t len);
 
+#define BITCPY_PAD_BYTES 8  // bitcpy_padded() 要求源和目标区间之后至少可访问的字节数
+
+/**
+ * @brief 带填充缓冲区的位级内存拷贝，适用于大量短拷贝（8-255 位）
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param src       源缓冲区（指向起始字节）
+ * @param src_bit   源起始位偏移（0-7）
+ * @param len       要拷贝的位数
+ *
+ * 结果与 bitcpy() 相同，区间之外的位保持不变，但访问范围更宽：
+ * - src 缓冲区在 (src_bit + len + 7) / 8 字节之后还要有 BITCPY_PAD_BYTES 字节可读
+ * - dest 缓冲区在 (dest_bit + len + 7) / 8 字节之后还要有 BITCPY_PAD_BYTES 字节可读写，
+ *   这些字节会被读出再原样写回，因此不能同时被其他线程写入
+ * - 源和目标区间不能重叠
+ *
+ * === 底层优化策略 ===
+ * 目标按 64 位字处理，每个字从源读取 8 字节（非对齐时 9 字节）移位拼接后整字写入，
+ * 首尾两个字带掩码读-改-写：没有阶段1/3/4 的逐字节循环和分支，
+ * 也不需要 bitcpy() 在剩余恰好 64 位时退回字节循环。len 超过 1024 位时直接调用 bitcpy()。
+ */
+void bitcpy_padded(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 支持重叠区间的位级内存移动（类似 memmove）
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param src       源缓冲区（指向起始字节）
+ * @param src_bit   源起始位偏移（0-7）
+ * @param len       要移动的位数
+ *
+ * 参数要求与 bitcpy() 相同，但源区间和目标区间可以任意重叠。
+ *
+ * === 方向选择 ===
+ * - 两端字节对齐且 len 是 8 的倍数：直接调用 memmove
+ * - 目标位地址 <= 源位地址，或两区间不重叠：直接调用 bitcpy()（正向拷贝）
+ * - 目标位地址 > 源位地址且区间重叠：按地址从高到低执行反向的阶段1-4
+ *   1. 处理末尾 1-7 位，使目标结束位置对齐到字节边界
+ *   2. 64位块：从高地址向低地址，每块先读取 8/9 字节再写入 8 字节
+ *   3. 字节级处理
+ *   4. 处理与目标起始位同处一个字节的前导 1-7 位
+ *
+ * 不分配任何临时缓冲区，重叠时也只读写一遍数据。
+ */
+void bitmove(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 在位向量中间插入 k 位，其后的位整体后移 k 位
+ * @param buf    位向量，从 buf 第 0 字节的第 0 位开始（位序与 bitcpy() 相同）
+ * @param used   插入前位向量的有效位数
+ * @param pos    插入位置（0 <= pos <= used）：原来的 [pos, used) 移到 [pos + k, used + k)
+ * @param src    插入的数据，从 src 第 src_bit 位开始的 k 位；为 NULL 时插入 k 个 0
+ * @param src_bit 源起始位偏移（0-7）
+ * @param k      插入的位数
+ *
+ * buf 至少需要 (used + k + 7) / 8 字节，[used + k, 该字节末尾) 的位保持不变；src 不能与 buf 重叠。
+ * 原地用 bitmove() 把尾部向高地址移动（64 位块从高地址向低地址移位拼接），
+ * 再用 bitcpy()（src 为 NULL 时用 bitfill()）写入插入的位；不分配内存，代价为 O((used - pos) / 64) 次字操作。
+ */
+void bitinsert(uint8_t* buf, uint64_t used, uint64_t pos,
+               const uint8_t* src, uint8_t src_bit, uint64_t k);
+
+/**
+ * @brief 删除位向量中间的 k 位，其后的位整体前移 k 位
+ * @param buf    位向量，从 buf 第 0 字节的第 0 位开始
+ * @param used   删除前位向量的有效位数
+ * @param pos    删除位置：原来的 [pos + k, used) 移到 [pos, used - k)
+ * @param k      删除的位数（pos + k <= used）
+ *
+ * [used - k, used) 在删除后不再属于位向量，这些位不被修改。
+ * 原地用 bitmove() 把尾部向低地址移动（正向 bitcpy()，可使用阶段2的 SIMD 内核），不分配内存。
+ */
+void bitdelete(uint8_t* buf, uint64_t used, uint64_t pos, uint64_t k);
+
+/**
+ * @brief 流式位级内存拷贝，适用于远大于末级缓存的拷贝
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param src       源缓冲区（指向起始字节）
+ * @param src_bit   源起始位偏移（0-7）
+ * @param len       要拷贝的位数
+ *
+ * 参数要求和结果与 bitcpy() 相同，区别在于目标数据绕过缓存直接写入内存，
+ * 不会把调用者的热数据挤出缓存；拷贝完成后目标数据不在缓存中。
+ *
+ * === 底层优化策略 ===
+ * - len < 8192 位（1 KiB）或非 x86 平台：直接调用 bitcpy()
+ * - 首部：用 bitcpy() 拷贝到目标的下一个 64 字节边界
+ * - 主体：整缓存行用非临时存储（MOVNTDQ，SSE2/AVX2/AVX-512 按 CPUID 选择）写入，
+ *   源数据用 PREFETCHNTA 提前 512 字节预取，src_bit != 0 时与阶段2内核相同地移位拼接
+ * - 尾部：不足一个缓存行的部分用 bitcpy() 处理
+ * - 返回前执行 SFENCE，保证非临时存储对其他线程可见
+ */
+void bitcpy_stream(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief MSB 优先位序的位级内存拷贝
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7），0 表示最高有效位
+ * @param src       源缓冲区（指向起始字节）
+ * @param src_bit   源起始位偏移（0-7），0 表示最高有效位
+ * @param len       要拷贝的位数
+ *
+ * 参数要求、重叠规则和访问范围与 bitcpy() 相同，只有位序不同：
+ * 位 0 是字节的最高有效位（MSB），位序号递增时从高位走向低位再进入下一字节，
+ * 即 H.264 码流、ASN.1 PER 和网络协议头使用的位序。
+ *
+ * === 底层优化策略 ===
+ * 与 bitcpy() 相同的快速路径和阶段1-4，移位方向相反：
+ * - 阶段2按大端序整字读写 64 位块：out = (load_be64(src) << src_bit) | (src[8] >> (8 - src_bit))
+ * - src_bit != 0 且剩余 >= 256 位时先由 SIMD 内核处理
+ *   （每字节 (src[i] << s) | (src[i+1] >> (8 - s))，16 位通道移位加字节掩码；
+ *   AVX-512BW > AVX2 > SSE2，首次调用时按 CPUID 选定）
+ */
+void bitcpy_msb(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 把位区间全部置为 0 或 1（类似 memset）
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param len       位数
+ * @param value     0 表示清零，非 0 表示置 1
+ *
+ * dest 缓冲区至少需要 (dest_bit + len + 7) / 8 字节，区间之外的位保持不变。
+ *
+ * === 底层优化策略 ===
+ * - 首尾不足一个字节的部分带掩码读-改-写，中间整字节调用 memset
+ * - 中间部分 >= 4 MiB 时（x86）：整缓存行用非临时存储（MOVNTDQ，SSE2/AVX2/AVX-512 按 CPUID 选择）写入，
+ *   不把调用者的热数据挤出缓存；返回前执行 SFENCE
+ */
+void bitfill(uint8_t* dest, uint8_t dest_bit, uint64_t len, int value);
+
+/**
+ * @brief 批量拷贝描述符，字段含义与 bitcpy() 的同名参数相同
+ */
+typedef struct {
+    uint8_t* dest;
+    const uint8_t* src;
+    uint64_t len;
+    uint8_t dest_bit;
+    uint8_t src_bit;
+} bitcpy_desc;
+
+/**
+ * @brief 批量执行多个相互独立的位拷贝
+ * @param descs  描述符数组，每个描述符的参数要求与 bitcpy() 相同
+ * @param n      描述符个数
+ *
+ * 结果等价于对每个描述符调用一次 bitcpy()，适合大量短拷贝（几位到几百位）连续发出的场景。
+ *
+ * === 参数要求（调用者保证） ===
+ * - 各描述符之间相互独立：任一描述符的目标区间不与其他描述符的源或目标区间重叠
+ * - 单个描述符的源和目标区间也不重叠
+ * - 执行顺序不保证与数组顺序一致
+ *
+ * === 底层优化策略 ===
+ * - 每次取最多 1024 个描述符，用计数排序按 (src_bit, dest_bit) 分成 64 类，
+ *   同一类内移位量和掩码是循环不变量，分支可预测
+ * - 按排序后的顺序提前预取后续描述符的源和目标缓存行
+ * - 短拷贝（<= 512 位）每步一次 8 字节读-改-写处理 56 位，最后一步只读写实际覆盖的字节，
+ *   不经过 bitcpy() 的阶段分派
+ * - 长拷贝（> 512 位）直接调用 bitcpy()
+ */
+void bitcpy_batch(const bitcpy_desc* descs, size_t n);
+
+/*
+ * === 热路径统计（编译期开关 BITCPY_STATS） ===
+ * 编译 bitcpy.c 时定义 BITCPY_STATS，bitcpy() 会记录每次调用走过的路径：
+ * 快速路径、各阶段的次数和位数、阶段2 SIMD 内核与 64 位循环的迭代数、
+ * 源非对齐且剩余恰好 64 位时退回字节循环的次数，以及 len 和 (src_bit, dest_bit) 的直方图。
+ * 对各阶段求和满足 bits == fast_path_bits + phase1_bits + simd_bits + 64 * block64 + 8 * byte_iters + tail_bits。
+ *
+ * 计数器按线程分开存放（每个线程第一次调用时分配一块，线程退出后保留），
+ * 调用线程只写自己的计数器，没有原子读-改-写和跨线程的缓存行竞争；阶段内按循环次数一次累加，不在循环体内计数。
+ * 未定义 BITCPY_STATS 时不产生任何代码，下面两个函数只返回 0。
+ * 只统计 bitcpy() 本身（包括 bitmove() 等内部转交给 bitcpy() 的调用）。
+ */
+
+#define BITCPY_STATS_LEN_BUCKETS 64  // len 直方图：第 i 桶为 len 在 [2^i, 2^(i+1)) 内的调用数
+
+typedef struct {
+    uint64_t calls;           // 调用次数（len > 0）
+    uint64_t bits;            // 拷贝的总位数
+    uint64_t fast_path;       // 走 memcpy 快速路径的调用数
+    uint64_t fast_path_bits;
+    uint64_t phase1;          // 执行阶段1（dest_bit != 0）的调用数
+    uint64_t phase1_bits;
+    uint64_t simd_calls;      // 阶段2 SIMD 内核的调用数
+    uint64_t simd_bits;
+    uint64_t block64;         // 阶段2 64 位循环的迭代数
+    uint64_t block64_break;   // 源非对齐且剩余恰好 64 位，交给阶段3的次数
+    uint64_t byte_iters;      // 阶段3 字节循环的迭代数
+    uint64_t tail;            // 执行阶段4（剩余 1-7 位）的调用数
+    uint64_t tail_bits;
+    uint64_t len_hist[BITCPY_STATS_LEN_BUCKETS];
+    uint64_t offset_hist[8][8];  // [src_bit][dest_bit]，按调用时的参数统计
+} bitcpy_stats;
+
+/**
+ * @brief 汇总所有线程的计数器
+ * @param out  输出，未启用 BITCPY_STATS 时全部置 0
+ * @return 1 表示已启用统计，0 表示未启用
+ *
+ * 可以与 bitcpy() 并发调用：每个计数器的读取是原子的，但各计数器之间不是同一时刻的快照。
+ */
+int bitcpy_stats_snapshot(bitcpy_stats* out);
+
+/**
+ * @brief 把所有线程的计数器清零
+ *
+ * 与 bitcpy() 并发调用时，正在执行的调用的计数可能部分丢失。
+ */
+void bitcpy_stats_reset(void);
+
+/*
+ * === 调用记录（编译期开关 BITCPY_TRACE） ===
+ * 编译 bitcpy.c 时定义 BITCPY_TRACE，bitcpy_trace_start() 之后每次 bitcpy() 调用
+ * （包括 bitmove()、bitstream 等内部转交给 bitcpy() 的调用）都记录为一个 64 位整数，
+ * 写入二进制记录文件，供 bench --replay 按真实的参数分布重放。
+ * 设置环境变量 BITCPY_TRACE_FILE 时，第一次调用 bitcpy() 会自动开始记录到该文件，进程退出时结束，
+ * 不需要修改调用方代码；第一次调用 bitcpy() 之前已经调用 bitcpy_trace_start() 时忽略该环境变量。
+ *
+ * 文件格式：8 字节 BITCPY_TRACE_MAGIC，之后每条记录 8 字节（小端序）：
+ *   位 0-39 len（超过 BITCPY_TRACE_MAX_LEN 时记为该值），位 40-42 dest_bit，位 43-45 src_bit，
+ *   位 46-51 dest 地址 mod 64，位 52-57 src 地址 mod 64，位 58-63 保留为 0
+ *
+ * 每个线程先把记录攒在自己的缓冲区中（4096 条），满了才整块 fwrite，调用路径上只有一次写内存；
+ * 多线程时文件中的记录按块交错。未定义 BITCPY_TRACE 时不产生任何代码，bitcpy_trace_start() 返回 -1。
+ */
+
+#define BITCPY_TRACE_MAGIC "BCTRACE1"
+#define BITCPY_TRACE_MAX_LEN (((uint64_t)1 << 40) - 1)
+
+typedef struct {
+    uint64_t len;
+    uint8_t dest_bit;
+    uint8_t src_bit;
+    uint8_t dest_align;  // dest 地址 mod 64
+    uint8_t src_align;   // src 地址 mod 64
+} bitcpy_trace_call;
+
+static inline uint64_t bitcpy_trace_encode(const bitcpy_trace_call* c) {
+    uint64_t len = c->len > BITCPY_TRACE_MAX_LEN ? BITCPY_TRACE_MAX_LEN : c->len;
+    return len | ((uint64_t)(c->dest_bit & 7) << 40) | ((uint64_t)(c->src_bit & 7) << 43) |
+           ((uint64_t)(c->dest_align & 63) << 46) | ((uint64_t)(c->src_align & 63) << 52);
+}
+
+static inline void bitcpy_trace_decode(uint64_t rec, bitcpy_trace_call* c) {
+    c->len = rec & BITCPY_TRACE_MAX_LEN;
+    c->dest_bit = (uint8_t)((rec >> 40) & 7);
+    c->src_bit = (uint8_t)((rec >> 43) & 7);
+    c->dest_align = (uint8_t)((rec >> 46) & 63);
+    c->src_align = (uint8_t)((rec >> 52) & 63);
+}
+
+/**
+ * @brief 开始记录 bitcpy() 调用，写入 path（已有内容被覆盖）
+ * @return 0 成功；-1 无法创建文件，或编译时未定义 BITCPY_TRACE
+ *
+ * 正在记录时再次调用会先结束之前的记录。
+ */
+int bitcpy_trace_start(const char* path);
+
+/**
+ * @brief 写出所有线程缓冲区中的记录并关闭文件
+ * @return 0 成功（或没有正在进行的记录），-1 写入失败
+ *
+ * 可以与其他线程的 bitcpy() 并发调用（进程退出时的自动结束即是如此）：
+ * 与结束同时进行的调用可能记录也可能不记录，已写出的文件总是完整的记录序列。
+ * 不要与 bitcpy_trace_start() 并发调用。
+ */
+int bitcpy_trace_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // BITCPY_H
 
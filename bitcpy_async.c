@@ -0,0 +1,433 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitcpy_async.h"
+#include <pthread.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define ASYNC_DEFAULT_CAPACITY 1024
+#define ASYNC_CHUNK_BITS ((uint64_t)1 << 20)  // 切块大小，64 字节缓存行（512 位）的整数倍
+#define ASYNC_LEFT_BITS 24                    // 领取计数器低位：尚未领取的块数
+#define ASYNC_LEFT_MASK (((uint64_t)1 << ASYNC_LEFT_BITS) - 1)
+#define ASYNC_TAG_MASK (((uint64_t)1 << (64 - ASYNC_LEFT_BITS)) - 1)
+#define ASYNC_SPIN 128  // 休眠前空转重试的次数
+
+// 任务槽；seq 是环形队列的序号：
+//   seq == pos          空闲，可以提交位置 pos
+//   seq == pos + 1      已提交位置 pos 的任务，等待领取或正在执行
+//   seq == pos + 容量    位置 pos 的任务已完成，槽可以提交位置 pos + 容量
+typedef struct {
+    uint64_t seq;
+    bitcpy_desc desc;
+    uint64_t submit_ns;
+    // 以下字段由领取任务的工作线程在切块前写入，窃取者在成功领取块之后才读取
+    uint64_t origin;      // dest 相对其缓存行起点的位偏移，块位置以该缓存行起点为原点
+    uint64_t begin;       // 目标起始位 = origin + dest_bit
+    uint64_t end;         // 目标结束位（不含）
+    uint64_t chunk_bits;
+    uint64_t first;       // 第一个块的编号
+    uint64_t nchunks;
+    uint64_t claim;       // 高 40 位为任务位置，低 24 位为尚未领取的块数
+    uint64_t remaining;   // 尚未执行完的块数，减到 0 的线程负责完成任务
+} async_cell;
+
+// 工作线程的公布槽位和统计；统计只由该线程写入
+typedef struct {
+    uint64_t active;  // 正在切块执行的任务位置 + 1，0 表示没有
+    uint64_t completed;
+    uint64_t bits;
+    uint64_t chunks;
+    uint64_t stolen_chunks;
+    uint64_t latency_total_ns;
+    uint64_t latency_max_ns;
+    uint64_t latency_hist[BITCPY_ASYNC_LATENCY_BUCKETS];
+} async_worker;
+
+typedef struct {
+    bitcpy_queue* q;
+    unsigned index;
+} async_thread_arg;
+
+struct bitcpy_queue {
+    uint64_t enqueue_pos;  // 下一个提交位置，也是累计提交数
+    uint8_t pad0[56];
+    uint64_t dequeue_pos;  // 下一个领取位置
+    uint8_t pad1[56];
+    async_cell* cells;
+    uint64_t mask;         // 容量 - 1
+    async_worker* workers;
+    async_thread_arg* args;
+    pthread_t* threads;
+    unsigned nworkers;
+    uint64_t rejected;
+    uint64_t create_ns;
+    // 休眠和唤醒：计数器用原子操作，只有计数器非零时提交和完成方才加锁
+    pthread_mutex_t lock;
+    pthread_cond_t work;  // 工作线程等待新任务或可窃取的块
+    pthread_cond_t done;  // bitcpy_wait() 等待任务完成
+    unsigned sleepers;
+    unsigned waiters;
+    int stop;
+};
+
+static unsigned online_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (unsigned)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+#endif
+}
+
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (uint64_t)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// 单写者计数器：只有所属线程写入，bitcpy_queue_get_stats() 并发读取
+static inline void counter_add(uint64_t* c, uint64_t n) {
+    __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// 已有线程休眠时加锁唤醒；调用者先发布新状态，再用全序栅栏保证与休眠方对计数器和状态的检查不会互相错过
+static void wake(bitcpy_queue* q, unsigned* count, pthread_cond_t* cond, int all) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(count, __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&q->lock);
+    if (all) {
+        pthread_cond_broadcast(cond);
+    } else {
+        pthread_cond_signal(cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+}
+
+int bitcpy_poll(bitcpy_queue* q, bitcpy_handle h) {
+    if (h == 0) return 1;
+    uint64_t pos = h - 1;
+    uint64_t seq = __atomic_load_n(&q->cells[pos & q->mask].seq, __ATOMIC_ACQUIRE);
+    return (int64_t)(seq - (pos + q->mask + 1)) >= 0;
+}
+
+void bitcpy_wait(bitcpy_queue* q, bitcpy_handle h) {
+    for (unsigned i = 0; i < ASYNC_SPIN; i++) {
+        if (bitcpy_poll(q, h)) return;
+    }
+    pthread_mutex_lock(&q->lock);
+    __atomic_add_fetch(&q->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!bitcpy_poll(q, h)) {
+        pthread_cond_wait(&q->done, &q->lock);
+    }
+    __atomic_sub_fetch(&q->waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&q->lock);
+}
+
+bitcpy_handle bitcpy_submit(bitcpy_queue* q, const bitcpy_desc* d) {
+    uint64_t pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    async_cell* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        uint64_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 槽中还是上一轮的任务（排队或执行中）：在途任务已达容量
+            __atomic_add_fetch(&q->rejected, 1, __ATOMIC_RELAXED);
+            return 0;
+        } else {
+            pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->desc = *d;
+    cell->submit_ns = now_ns();
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    wake(q, &q->sleepers, &q->work, 0);
+    return pos + 1;
+}
+
+static int queue_pop(bitcpy_queue* q, uint64_t* out) {
+    uint64_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        async_cell* cell = &q->cells[pos & q->mask];
+        uint64_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *out = pos;
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// 记录统计并释放槽；调用之后不能再访问该槽
+static void finish_job(bitcpy_queue* q, async_worker* w, uint64_t pos) {
+    async_cell* cell = &q->cells[pos & q->mask];
+    uint64_t latency = now_ns() - cell->submit_ns;
+    unsigned bucket = latency ? 63 - (unsigned)__builtin_clzll(latency) : 0;
+    if (bucket >= BITCPY_ASYNC_LATENCY_BUCKETS) bucket = BITCPY_ASYNC_LATENCY_BUCKETS - 1;
+    counter_add(&w->completed, 1);
+    counter_add(&w->bits, cell->desc.len);
+    counter_add(&w->latency_total_ns, latency);
+    counter_add(&w->latency_hist[bucket], 1);
+    if (latency > w->latency_max_ns) {
+        __atomic_store_n(&w->latency_max_ns, latency, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&cell->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    wake(q, &q->waiters, &q->done, 1);
+}
+
+// 领取任务的下一个块；任务已领取完或槽已被复用时返回 0
+static int claim_chunk(bitcpy_queue* q, uint64_t pos, uint64_t* chunk) {
+    async_cell* cell = &q->cells[pos & q->mask];
+    uint64_t tag = pos & ASYNC_TAG_MASK;
+    uint64_t c = __atomic_load_n(&cell->claim, __ATOMIC_ACQUIRE);
+    for (;;) {
+        if ((c >> ASYNC_LEFT_BITS) != tag || (c & ASYNC_LEFT_MASK) == 0) return 0;
+        if (__atomic_compare_exchange_n(&cell->claim, &c, c - 1, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            // 领取成功说明任务尚未完成，切块参数可以安全读取
+            *chunk = cell->first + cell->nchunks - (c & ASYNC_LEFT_MASK);
+            return 1;
+        }
+    }
+}
+
+static void run_chunk(bitcpy_queue* q, async_worker* w, uint64_t pos, uint64_t chunk, int stolen) {
+    async_cell* cell = &q->cells[pos & q->mask];
+    uint64_t begin = chunk * cell->chunk_bits;
+    uint64_t end = begin + cell->chunk_bits;
+    if (begin < cell->begin) begin = cell->begin;
+    if (end > cell->end) end = cell->end;
+
+    uint64_t dest_pos = begin - cell->origin;
+    uint64_t src_pos = cell->desc.src_bit + (begin - cell->begin);
+    bitcpy(cell->desc.dest + (dest_pos >> 3), dest_pos & 7,
+           cell->desc.src + (src_pos >> 3), src_pos & 7, end - begin);
+
+    counter_add(&w->chunks, 1);
+    if (stolen) counter_add(&w->stolen_chunks, 1);
+    if (__atomic_sub_fetch(&cell->remaining, 1, __ATOMIC_ACQ_REL) == 0) {
+        finish_job(q, w, pos);
+    }
+}
+
+// 执行从队列领取的任务：小任务直接拷贝，大任务切块后公布给其他线程一起执行
+static void run_job(bitcpy_queue* q, unsigned self, uint64_t pos) {
+    async_cell* cell = &q->cells[pos & q->mask];
+    async_worker* w = &q->workers[self];
+    const bitcpy_desc* d = &cell->desc;
+    if (q->nworkers == 1 || d->len < 2 * ASYNC_CHUNK_BITS) {
+        bitcpy(d->dest, d->dest_bit, d->src, d->src_bit, d->len);
+        counter_add(&w->chunks, 1);
+        finish_job(q, w, pos);
+        return;
+    }
+
+    // 块编号不能超过领取计数器的低位宽度，超长的任务加大块大小
+    cell->origin = (uint64_t)((uintptr_t)d->dest & 63) << 3;
+    cell->begin = cell->origin + d->dest_bit;
+    cell->end = cell->begin + d->len;
+    uint64_t chunk = ASYNC_CHUNK_BITS;
+    while ((cell->end + chunk - 1) / chunk - cell->begin / chunk > ASYNC_LEFT_MASK) {
+        chunk <<= 1;
+    }
+    cell->chunk_bits = chunk;
+    cell->first = cell->begin / chunk;
+    cell->nchunks = (cell->end + chunk - 1) / chunk - cell->first;
+    __atomic_store_n(&cell->remaining, cell->nchunks, __ATOMIC_RELAXED);
+    __atomic_store_n(&cell->claim, ((pos & ASYNC_TAG_MASK) << ASYNC_LEFT_BITS) | cell->nchunks,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&w->active, pos + 1, __ATOMIC_RELEASE);
+    wake(q, &q->sleepers, &q->work, 1);
+
+    uint64_t idx;
+    while (claim_chunk(q, pos, &idx)) {
+        run_chunk(q, w, pos, idx, 0);
+    }
+    __atomic_store_n(&w->active, 0, __ATOMIC_RELEASE);
+}
+
+// 从其他线程公布的任务中窃取一个块
+static int steal_chunk(bitcpy_queue* q, unsigned self) {
+    for (unsigned i = 1; i < q->nworkers; i++) {
+        unsigned victim = (self + i) % q->nworkers;
+        uint64_t a = __atomic_load_n(&q->workers[victim].active, __ATOMIC_ACQUIRE);
+        uint64_t idx;
+        if (a != 0 && claim_chunk(q, a - 1, &idx)) {
+            run_chunk(q, &q->workers[self], a - 1, idx, 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 是否有可领取的任务或可窃取的块；只读取原子字段
+static int has_work(bitcpy_queue* q) {
+    uint64_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&q->cells[pos & q->mask].seq, __ATOMIC_ACQUIRE) == pos + 1) return 1;
+    for (unsigned i = 0; i < q->nworkers; i++) {
+        uint64_t a = __atomic_load_n(&q->workers[i].active, __ATOMIC_ACQUIRE);
+        if (a == 0) continue;
+        uint64_t c = __atomic_load_n(&q->cells[(a - 1) & q->mask].claim, __ATOMIC_ACQUIRE);
+        if ((c >> ASYNC_LEFT_BITS) == ((a - 1) & ASYNC_TAG_MASK) && (c & ASYNC_LEFT_MASK) != 0) return 1;
+    }
+    return 0;
+}
+
+static void* async_worker_main(void* arg) {
+    bitcpy_queue* q = ((async_thread_arg*)arg)->q;
+    unsigned self = ((async_thread_arg*)arg)->index;
+    unsigned idle = 0;
+    for (;;) {
+        uint64_t pos;
+        if (queue_pop(q, &pos)) {
+            run_job(q, self, pos);
+            idle = 0;
+            continue;
+        }
+        if (steal_chunk(q, self)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < ASYNC_SPIN) continue;
+        idle = 0;
+
+        // 先登记为休眠者再检查一次，提交方发布任务后看到休眠者才会加锁唤醒
+        pthread_mutex_lock(&q->lock);
+        __atomic_add_fetch(&q->sleepers, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while (!q->stop && !has_work(q)) {
+            pthread_cond_wait(&q->work, &q->lock);
+        }
+        __atomic_sub_fetch(&q->sleepers, 1, __ATOMIC_RELAXED);
+        int stop = q->stop;
+        pthread_mutex_unlock(&q->lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+static void stop_workers(bitcpy_queue* q, unsigned started) {
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_broadcast(&q->work);
+    pthread_mutex_unlock(&q->lock);
+    for (unsigned i = 0; i < started; i++) {
+        pthread_join(q->threads[i], NULL);
+    }
+}
+
+static void free_queue(bitcpy_queue* q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->work);
+    pthread_cond_destroy(&q->done);
+    free(q->cells);
+    free(q->workers);
+    free(q->args);
+    free(q->threads);
+    free(q);
+}
+
+bitcpy_queue* bitcpy_queue_create(unsigned nthreads, size_t capacity) {
+    if (nthreads == 0) nthreads = online_cpus();
+    if (capacity == 0) capacity = ASYNC_DEFAULT_CAPACITY;
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+
+    bitcpy_queue* q = (bitcpy_queue*)calloc(1, sizeof(bitcpy_queue));
+    if (q == NULL) return NULL;
+    q->cells = (async_cell*)calloc(cap, sizeof(async_cell));
+    q->workers = (async_worker*)calloc(nthreads, sizeof(async_worker));
+    q->args = (async_thread_arg*)calloc(nthreads, sizeof(async_thread_arg));
+    q->threads = (pthread_t*)calloc(nthreads, sizeof(pthread_t));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->work, NULL);
+    pthread_cond_init(&q->done, NULL);
+    if (q->cells == NULL || q->workers == NULL || q->args == NULL || q->threads == NULL) {
+        free_queue(q);
+        return NULL;
+    }
+    for (size_t i = 0; i < cap; i++) {
+        q->cells[i].seq = i;
+    }
+    q->mask = cap - 1;
+    q->create_ns = now_ns();
+
+    for (unsigned i = 0; i < nthreads; i++) {
+        q->args[i].q = q;
+        q->args[i].index = i;
+    }
+    // 工作线程读取 nworkers 决定窃取范围，先设好再逐个启动
+    q->nworkers = nthreads;
+    for (unsigned i = 0; i < nthreads; i++) {
+        if (pthread_create(&q->threads[i], NULL, async_worker_main, &q->args[i]) != 0) {
+            stop_workers(q, i);
+            free_queue(q);
+            return NULL;
+        }
+    }
+    return q;
+}
+
+void bitcpy_queue_destroy(bitcpy_queue* q) {
+    if (q == NULL) return;
+    // 位置在 enqueue_pos - 容量 之前的任务的槽已被复用，必然已完成
+    uint64_t end = __atomic_load_n(&q->enqueue_pos, __ATOMIC_ACQUIRE);
+    uint64_t pos = end > q->mask + 1 ? end - (q->mask + 1) : 0;
+    for (; pos < end; pos++) {
+        bitcpy_wait(q, pos + 1);
+    }
+    stop_workers(q, q->nworkers);
+    free_queue(q);
+}
+
+void bitcpy_queue_get_stats(bitcpy_queue* q, bitcpy_queue_stats* out) {
+    memset(out, 0, sizeof(*out));
+    out->submitted = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    out->rejected = __atomic_load_n(&q->rejected, __ATOMIC_RELAXED);
+    for (unsigned i = 0; i < q->nworkers; i++) {
+        async_worker* w = &q->workers[i];
+        out->completed += __atomic_load_n(&w->completed, __ATOMIC_RELAXED);
+        out->bits += __atomic_load_n(&w->bits, __ATOMIC_RELAXED);
+        out->chunks += __atomic_load_n(&w->chunks, __ATOMIC_RELAXED);
+        out->stolen_chunks += __atomic_load_n(&w->stolen_chunks, __ATOMIC_RELAXED);
+        out->latency_total_ns += __atomic_load_n(&w->latency_total_ns, __ATOMIC_RELAXED);
+        uint64_t m = __atomic_load_n(&w->latency_max_ns, __ATOMIC_RELAXED);
+        if (m > out->latency_max_ns) out->latency_max_ns = m;
+        for (int b = 0; b < BITCPY_ASYNC_LATENCY_BUCKETS; b++) {
+            out->latency_hist[b] += __atomic_load_n(&w->latency_hist[b], __ATOMIC_RELAXED);
+        }
+    }
+    out->uptime_ns = now_ns() - q->create_ns;
+}
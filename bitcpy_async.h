@@ -0,0 +1,95 @@
+#ifndef BITCPY_ASYNC_H
+#define BITCPY_ASYNC_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * === 异步位拷贝队列 ===
+ * 提交线程把 bitcpy_desc 放入队列后立即返回句柄，由队列自带的工作线程调用 bitcpy() 完成拷贝，
+ * 适合不能在当前线程上同步拷贝的场景（例如网络线程突发产生的拷贝任务）。
+ *
+ * === 实现 ===
+ * - 任务槽是一个容量为 2 的幂的无锁 MPMC 环形队列（每个槽带序号，提交和领取各一次 CAS），
+ *   句柄就是任务在环中的位置 + 1。槽在任务完成后才释放给后续提交，
+ *   因此队列容量同时限制了排队和执行中的任务数，句柄的完成状态只需比较槽的序号
+ * - 工作线程从队列领取任务；超过 1 Mbit 的任务按目标的 64 字节缓存行边界切成 1 Mbit 的块，
+ *   领取者把任务公布在自己的槽位上，空闲的工作线程从其他线程公布的任务中窃取块。
+ *   块的领取计数器高位带任务位置，任务完成、槽被复用后旧的窃取尝试会失败
+ * - 块之间不共享目标字节，每块直接调用 bitcpy()（使用阶段2的 SIMD 内核）
+ * - 没有任务时工作线程在条件变量上休眠，提交和等待只在有线程休眠时才加锁唤醒
+ *
+ * 与 bitcpy_batch() 相同，同时在途的任务之间不能有目标区间与其他任务的源或目标区间重叠，
+ * 执行顺序不保证与提交顺序一致。
+ */
+
+typedef struct bitcpy_queue bitcpy_queue;
+typedef uint64_t bitcpy_handle;  // 0 表示提交失败
+
+#define BITCPY_ASYNC_LATENCY_BUCKETS 40  // 延迟直方图：第 i 桶为延迟在 [2^i, 2^(i+1)) 纳秒内的任务数
+
+typedef struct {
+    uint64_t submitted;      // 成功提交的任务数
+    uint64_t rejected;       // 队列满而失败的提交数
+    uint64_t completed;      // 完成的任务数
+    uint64_t bits;           // 完成任务的总位数
+    uint64_t chunks;         // 执行的块数（未切分的任务算 1 块）
+    uint64_t stolen_chunks;  // 被其他工作线程窃取执行的块数
+    uint64_t latency_total_ns;  // 从提交到完成的延迟之和
+    uint64_t latency_max_ns;
+    uint64_t latency_hist[BITCPY_ASYNC_LATENCY_BUCKETS];
+    uint64_t uptime_ns;      // 队列创建以来的时间，吞吐量 = bits / uptime_ns
+} bitcpy_queue_stats;
+
+/**
+ * @brief 创建队列并启动工作线程
+ * @param nthreads  工作线程数，0 表示使用在线 CPU 数
+ * @param capacity  同时在途（排队和执行中）的任务数上限，向上取整到 2 的幂，0 表示 1024
+ * @return 队列，失败返回 NULL
+ */
+bitcpy_queue* bitcpy_queue_create(unsigned nthreads, size_t capacity);
+
+/**
+ * @brief 等待所有已提交的任务完成，停止工作线程并释放队列
+ *
+ * 调用时不应再有其他线程向该队列提交任务。
+ */
+void bitcpy_queue_destroy(bitcpy_queue* q);
+
+/**
+ * @brief 提交一个拷贝任务，不阻塞
+ * @param q  队列
+ * @param d  拷贝描述符，参数要求与 bitcpy() 相同；描述符本身在返回后即可复用，
+ *           但源和目标缓冲区要保持有效直到任务完成
+ * @return 任务句柄；在途任务数已达容量时返回 0，调用者可以稍后重试或改为同步调用 bitcpy()
+ *
+ * 可以从任意多个线程并发调用。
+ */
+bitcpy_handle bitcpy_submit(bitcpy_queue* q, const bitcpy_desc* d);
+
+/**
+ * @brief 查询任务是否完成，不阻塞
+ * @return 1 已完成（目标数据对调用线程可见），0 尚未完成
+ */
+int bitcpy_poll(bitcpy_queue* q, bitcpy_handle h);
+
+/**
+ * @brief 阻塞等待任务完成，返回后目标数据对调用线程可见
+ */
+void bitcpy_wait(bitcpy_queue* q, bitcpy_handle h);
+
+/**
+ * @brief 读取队列的吞吐量和延迟统计
+ *
+ * 可以与提交和执行并发调用，各计数器不是同一时刻的快照。
+ */
+void bitcpy_queue_get_stats(bitcpy_queue* q, bitcpy_queue_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITCPY_ASYNC_H
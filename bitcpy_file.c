@@ -0,0 +1,186 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include "bitcpy_file.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FILE_WINDOW_DEFAULT ((size_t)64 << 20)  // mmap 窗口的目标字节数
+#define FILE_STREAM_BYTES ((size_t)1 << 20)     // pread/pwrite 回退路径的缓冲区大小
+
+static size_t file_window = FILE_WINDOW_DEFAULT;
+static size_t file_stream_bytes = FILE_STREAM_BYTES;
+static int file_force_stream = 0;
+
+void bitcpy_file_set_window(size_t bytes) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (bytes == 0) bytes = FILE_WINDOW_DEFAULT;
+    file_window = (bytes + page - 1) / page * page;
+}
+
+void bitcpy_file_set_stream(size_t bytes) {
+    file_force_stream = bytes != 0;
+    file_stream_bytes = bytes != 0 ? bytes : FILE_STREAM_BYTES;
+}
+
+// 一次映射：base/len 为实际映射（起点对齐到页），ptr 指向请求的第一个字节
+typedef struct {
+    uint8_t* base;
+    size_t len;
+    uint8_t* ptr;
+} file_map;
+
+static int map_range(file_map* m, int fd, uint64_t off, size_t n, int prot, size_t page) {
+    uint64_t start = off & ~(uint64_t)(page - 1);
+    m->len = (size_t)(off - start) + n;
+    void* p = mmap(NULL, m->len, prot, MAP_SHARED, fd, (off_t)start);
+    if (p == MAP_FAILED) return -1;
+    m->base = (uint8_t*)p;
+    m->ptr = m->base + (off - start);
+    madvise(m->base, m->len, MADV_SEQUENTIAL);
+    return 0;
+}
+
+// 映射一个窗口的源和目标字节并调用 bitcpy()；任一映射失败返回 -1，由调用者改用 pread/pwrite
+static int copy_window_mmap(int dst_fd, uint64_t dst_bit, int src_fd, uint64_t src_bit,
+                            uint64_t n, size_t page) {
+    file_map src, dst;
+    size_t src_bytes = (size_t)(((src_bit & 7) + n + 7) >> 3);
+    size_t dst_bytes = (size_t)(((dst_bit & 7) + n + 7) >> 3);
+    if (map_range(&src, src_fd, src_bit >> 3, src_bytes, PROT_READ, page) != 0) return -1;
+    if (map_range(&dst, dst_fd, dst_bit >> 3, dst_bytes, PROT_READ | PROT_WRITE, page) != 0) {
+        munmap(src.base, src.len);
+        return -1;
+    }
+    bitcpy(dst.ptr, (uint8_t)(dst_bit & 7), src.ptr, (uint8_t)(src_bit & 7), n);
+    // 源窗口不会再被访问；目标窗口的脏页在 munmap 后照常由内核写回
+    madvise(src.base, src.len, MADV_DONTNEED);
+    munmap(src.base, src.len);
+    munmap(dst.base, dst.len);
+    return 0;
+}
+
+// 读取 n 字节，遇到文件末尾时提前结束；*got 为实际读取的字节数
+static int read_full(int fd, uint8_t* buf, size_t n, uint64_t off, size_t* got) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t r = pread(fd, buf + done, n - done, (off_t)(off + done));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break;
+        done += (size_t)r;
+    }
+    *got = done;
+    return 0;
+}
+
+static int write_full(int fd, const uint8_t* buf, size_t n, uint64_t off) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t r = pwrite(fd, buf + done, n - done, (off_t)(off + done));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += (size_t)r;
+    }
+    return 0;
+}
+
+// 回退路径：读入源字节和目标首尾不完整的字节，在缓冲区中 bitcpy() 后整段写回
+static int copy_window_stream(int dst_fd, uint64_t dst_bit, int src_fd, uint64_t src_bit,
+                              uint64_t n, uint8_t* src_buf, uint8_t* dst_buf) {
+    size_t src_bytes = (size_t)(((src_bit & 7) + n + 7) >> 3);
+    size_t dst_bytes = (size_t)(((dst_bit & 7) + n + 7) >> 3);
+    size_t got;
+    if (read_full(src_fd, src_buf, src_bytes, src_bit >> 3, &got) != 0) return -1;
+    if (got < src_bytes) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((dst_bit & 7) != 0) {
+        if (read_full(dst_fd, dst_buf, 1, dst_bit >> 3, &got) != 0) return -1;
+        if (got == 0) dst_buf[0] = 0;
+    }
+    if (((dst_bit + n) & 7) != 0) {
+        size_t last = dst_bytes - 1;
+        if (read_full(dst_fd, dst_buf + last, 1, (dst_bit >> 3) + last, &got) != 0) return -1;
+        if (got == 0) dst_buf[last] = 0;
+    }
+    bitcpy(dst_buf, (uint8_t)(dst_bit & 7), src_buf, (uint8_t)(src_bit & 7), n);
+    return write_full(dst_fd, dst_buf, dst_bytes, dst_bit >> 3);
+}
+
+int bitcpy_file(int dst_fd, uint64_t dst_bit, int src_fd, uint64_t src_bit, uint64_t len) {
+    if (len == 0) return 0;
+
+    struct stat st;
+    uint64_t src_need = (src_bit + len + 7) >> 3;
+    uint64_t dst_need = (dst_bit + len + 7) >> 3;
+    if (fstat(src_fd, &st) != 0) return -1;
+    if ((uint64_t)st.st_size < src_need) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (fstat(dst_fd, &st) != 0) return -1;
+    if ((uint64_t)st.st_size < dst_need && ftruncate(dst_fd, (off_t)dst_need) != 0) return -1;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#ifdef BITCPY_FILE_NO_MMAP
+    int use_mmap = 0;
+#else
+    int use_mmap = !file_force_stream;
+#endif
+    size_t stream_bytes = file_stream_bytes;
+    uint8_t* src_buf = NULL;
+    uint8_t* dst_buf = NULL;
+    int ret = 0;
+    while (len > 0) {
+        // 除最后一个窗口外，目标区间结束在字节边界上
+        size_t window = use_mmap ? file_window : stream_bytes;
+        uint64_t n = (uint64_t)window * 8 - (dst_bit & 7);
+        if (n > len) n = len;
+
+        if (use_mmap) {
+            if (copy_window_mmap(dst_fd, dst_bit, src_fd, src_bit, n, page) == 0) {
+                dst_bit += n;
+                src_bit += n;
+                len -= n;
+                continue;
+            }
+            use_mmap = 0;
+            continue;
+        }
+
+        if (src_buf == NULL) {
+            src_buf = (uint8_t*)malloc(stream_bytes + 1);
+            dst_buf = (uint8_t*)malloc(stream_bytes);
+            if (src_buf == NULL || dst_buf == NULL) {
+                errno = ENOMEM;
+                ret = -1;
+                break;
+            }
+        }
+        if (copy_window_stream(dst_fd, dst_bit, src_fd, src_bit, n, src_buf, dst_buf) != 0) {
+            ret = -1;
+            break;
+        }
+        dst_bit += n;
+        src_bit += n;
+        len -= n;
+    }
+    free(src_buf);
+    free(dst_buf);
+    return ret;
+}
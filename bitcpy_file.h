@@ -0,0 +1,53 @@
+#ifndef BITCPY_FILE_H
+#define BITCPY_FILE_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 文件到文件的位级拷贝，适用于大于物理内存的位图
+ * @param dst_fd    目标文件描述符，需要以读写方式打开（O_RDWR）
+ * @param dst_bit   目标起始位，相对目标文件第 0 字节的第 0 位（不限于 0-7）
+ * @param src_fd    源文件描述符，可读
+ * @param src_bit   源起始位，相对源文件第 0 字节的第 0 位
+ * @param len       要拷贝的位数
+ * @return 0 成功；-1 失败并设置 errno（源文件不足 (src_bit + len + 7) / 8 字节时为 EINVAL）
+ *
+ * 位序与 bitcpy() 相同，目标区间之外的位保持不变；目标文件不足 (dst_bit + len + 7) / 8 字节时先扩展。
+ * 两个描述符指向同一文件时，源和目标区间不能重叠。
+ *
+ * === 底层优化策略 ===
+ * 按窗口处理，默认每个窗口 64 MiB 目标数据：
+ * - 源和目标窗口分别 mmap（偏移向下对齐到页），对窗口调用 bitcpy()，使用其阶段2的 SIMD 内核
+ * - 除最后一个窗口外，每个窗口的目标区间都结束在字节边界上，下一个窗口从对齐的字节开始；
+ *   跨越窗口边界的源字节在两个窗口中各映射一次，边界处不需要额外拼接
+ * - 映射后 madvise(MADV_SEQUENTIAL) 让内核提前预读，源窗口用完后 madvise(MADV_DONTNEED) 释放页缓存的映射
+ * - mmap 失败（文件系统或描述符不支持映射）、定义 BITCPY_FILE_NO_MMAP 或调用 bitcpy_file_set_stream() 后，
+ *   改用 pread/pwrite 按 1 MiB 缓冲区流式处理，目标区间首尾不完整的字节先读出再合并写回
+ */
+int bitcpy_file(int dst_fd, uint64_t dst_bit, int src_fd, uint64_t src_bit, uint64_t len);
+
+/**
+ * @brief 设置 mmap 窗口大小
+ * @param bytes  每个窗口的目标字节数，向上取整到页大小；0 恢复默认值 64 MiB
+ *
+ * 应在发出文件拷贝之前设置，不要与 bitcpy_file() 并发调用。
+ */
+void bitcpy_file_set_window(size_t bytes);
+
+/**
+ * @brief 强制使用 pread/pwrite 回退路径
+ * @param bytes  回退路径每个窗口的目标字节数；0 恢复默认（优先 mmap，回退缓冲区 1 MiB）
+ *
+ * 主要用于测试回退路径；与 bitcpy_file_set_window() 一样不要与 bitcpy_file() 并发调用。
+ */
+void bitcpy_file_set_stream(size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITCPY_FILE_H
@@ -0,0 +1,117 @@
+#ifndef BITCPY_INLINE_H
+#define BITCPY_INLINE_H
+
+#include "bitcpy.h"
+
+/*
+ * === 编译期特化的内联 bitcpy ===
+ * 协议字段这类调用点的 dest_bit、src_bit、len 往往都是编译期常量（3、12、17、48 位……），
+ * 此时没有必要走出函数调用和 bitcpy() 的阶段1-4。
+ *
+ * - bitcpy_fixed()：len <= 64 时的内联实现。源最多读取 9 字节，目标最多两次读-改-写
+ *   （8 字节 + 1 字节），只访问 bitcpy() 允许访问的字节。参数为常量时字节数、移位和掩码
+ *   全部在编译期确定，通常化简为一到两次带掩码的整字读写。
+ * - BITCPY_INLINE()：三个参数都是编译期常量且 len <= 64 时展开为 bitcpy_fixed()，
+ *   否则调用 bitcpy()。每个参数只求值一次。不支持 __builtin_constant_p 的编译器上总是调用 bitcpy()。
+ * - C++：bitcpy<DestBit, SrcBit, Len>(dest, src)，Len <= 64 时使用 bitcpy_fixed()，否则调用 bitcpy()。
+ *
+ * 与 bitcpy() 一样假定主机是小端序。
+ */
+
+// 读取 n 字节（0-8）为小端 64 位整数；n 为常量时化简为一到两次普通读取（5-7 字节用两次重叠读取）
+static inline uint64_t bitcpy_load_bytes(const uint8_t* p, unsigned n) {
+    uint64_t v8;
+    uint32_t v4, hi4;
+    uint16_t v2;
+    switch (n) {
+    case 0: return 0;
+    case 1: return p[0];
+    case 2: memcpy(&v2, p, 2); return v2;
+    case 3: memcpy(&v2, p, 2); return v2 | ((uint64_t)p[2] << 16);
+    case 4: memcpy(&v4, p, 4); return v4;
+    case 8: memcpy(&v8, p, 8); return v8;
+    default:
+        memcpy(&v4, p, 4);
+        memcpy(&hi4, p + n - 4, 4);
+        return v4 | ((uint64_t)hi4 << (8 * (n - 4)));
+    }
+}
+
+// 写入 v 的低 n 字节（0-8）；5-7 字节用两次重叠写入，重叠部分的值相同
+static inline void bitcpy_store_bytes(uint8_t* p, unsigned n, uint64_t v) {
+    uint32_t v4, hi4;
+    uint16_t v2;
+    switch (n) {
+    case 0: return;
+    case 1: p[0] = (uint8_t)v; return;
+    case 2: v2 = (uint16_t)v; memcpy(p, &v2, 2); return;
+    case 3: v2 = (uint16_t)v; memcpy(p, &v2, 2); p[2] = (uint8_t)(v >> 16); return;
+    case 4: v4 = (uint32_t)v; memcpy(p, &v4, 4); return;
+    case 8: memcpy(p, &v, 8); return;
+    default:
+        v4 = (uint32_t)v;
+        hi4 = (uint32_t)(v >> (8 * (n - 4)));
+        memcpy(p + n - 4, &hi4, 4);
+        memcpy(p, &v4, 4);
+        return;
+    }
+}
+
+/**
+ * @brief len <= 64 时的内联位拷贝，参数要求与 bitcpy() 相同，另外要求 len <= 64
+ */
+static inline void bitcpy_fixed(uint8_t* dest, uint8_t dest_bit,
+                                const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    unsigned src_bytes = (unsigned)((src_bit + len + 7) >> 3);    // 1-9
+    unsigned dest_bytes = (unsigned)((dest_bit + len + 7) >> 3);  // 1-9
+
+    // 读取源数据：超过 8 字节时由第 9 字节补齐高位
+    uint64_t v;
+    if (src_bytes > 8) {
+        v = (bitcpy_load_bytes(src, 8) >> src_bit) | ((uint64_t)src[8] << (64 - src_bit));
+    } else {
+        v = bitcpy_load_bytes(src, src_bytes) >> src_bit;
+    }
+    if (len < 64) {
+        v &= ((uint64_t)1 << len) - 1;
+    }
+
+    // 写入目标：低 8 字节一次读-改-写，溢出的高位写入第 9 字节
+    uint64_t mask = (len < 64 ? ((uint64_t)1 << len) - 1 : ~(uint64_t)0) << dest_bit;
+    unsigned low_bytes = dest_bytes > 8 ? 8 : dest_bytes;
+    uint64_t w = bitcpy_load_bytes(dest, low_bytes);
+    bitcpy_store_bytes(dest, low_bytes, (w & ~mask) | (v << dest_bit));
+    if (dest_bytes > 8) {
+        uint8_t high_mask = (uint8_t)((1u << (dest_bit + len - 64)) - 1);
+        dest[8] = (uint8_t)((dest[8] & ~high_mask) | ((v >> (64 - dest_bit)) & high_mask));
+    }
+}
+
+#if defined(__GNUC__)
+#define BITCPY_INLINE(dest, dest_bit, src, src_bit, len)                              \
+    ((__builtin_constant_p(dest_bit) && __builtin_constant_p(src_bit) &&              \
+      __builtin_constant_p(len) && (uint64_t)(len) <= 64)                             \
+         ? bitcpy_fixed((dest), (uint8_t)(dest_bit), (src), (uint8_t)(src_bit), (len)) \
+         : bitcpy((dest), (uint8_t)(dest_bit), (src), (uint8_t)(src_bit), (len)))
+#else
+#define BITCPY_INLINE(dest, dest_bit, src, src_bit, len) \
+    bitcpy((dest), (uint8_t)(dest_bit), (src), (uint8_t)(src_bit), (len))
+#endif
+
+#ifdef __cplusplus
+/**
+ * @brief 编译期特化的位拷贝：bitcpy<DestBit, SrcBit, Len>(dest, src)
+ */
+template <unsigned DestBit, unsigned SrcBit, uint64_t Len>
+inline void bitcpy(uint8_t* dest, const uint8_t* src) {
+    static_assert(DestBit < 8 && SrcBit < 8, "bit offsets must be in [0, 7]");
+    if (Len <= 64) {
+        bitcpy_fixed(dest, (uint8_t)DestBit, src, (uint8_t)SrcBit, Len);
+    } else {
+        ::bitcpy(dest, (uint8_t)DestBit, src, (uint8_t)SrcBit, Len);
+    }
+}
+#endif
+
+#endif // BITCPY_INLINE_H
@@ -0,0 +1,197 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitcpy_parallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define PARALLEL_DEFAULT_THRESHOLD ((uint64_t)1 << 25)
+#define PARALLEL_LINE_BITS 512          // 块边界对齐到 64 字节缓存行
+#define PARALLEL_PARTS_PER_THREAD 4     // 每个线程平均领取的块数，用于平衡线程间的速度差异
+
+// 一次并行拷贝的参数；位置都以 dest 所在缓存行的起点为原点
+typedef struct {
+    uint8_t* dest;
+    const uint8_t* src;
+    uint64_t origin;      // dest 相对其缓存行起点的位偏移
+    uint64_t begin;       // 目标起始位 = origin + dest_bit
+    uint64_t end;         // 目标结束位（不含）
+    uint64_t chunk_bits;  // 块大小，PARALLEL_LINE_BITS 的整数倍
+    uint64_t nparts;
+    uint8_t src_bit;
+} parallel_job;
+
+static pthread_mutex_t pool_call_lock = PTHREAD_MUTEX_INITIALIZER;  // 串行化并行拷贝与线程池配置
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;       // 保护以下任务状态
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static pthread_t* pool_threads = NULL;
+static unsigned pool_nworkers = 0;  // 工作线程数（不含调用线程）
+static int pool_started = 0;
+static int pool_stop = 0;
+static unsigned long pool_generation = 0;
+static parallel_job pool_job;
+static uint64_t pool_next_part = 0;
+static uint64_t pool_pending = 0;
+static uint64_t pool_threshold = PARALLEL_DEFAULT_THRESHOLD;
+
+static unsigned online_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (unsigned)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+#endif
+}
+
+static void run_part(const parallel_job* job, uint64_t part) {
+    uint64_t begin = part * job->chunk_bits;
+    uint64_t end = begin + job->chunk_bits;
+    if (begin < job->begin) begin = job->begin;
+    if (end > job->end) end = job->end;
+    
+    uint64_t dest_pos = begin - job->origin;
+    uint64_t src_pos = job->src_bit + (begin - job->begin);
+    bitcpy(job->dest + (dest_pos >> 3), dest_pos & 7,
+           job->src + (src_pos >> 3), src_pos & 7, end - begin);
+}
+
+// 领取并执行块直到全部领取完；调用和返回时都持有 pool_lock
+static void drain_parts(void) {
+    while (pool_next_part < pool_job.nparts) {
+        uint64_t part = pool_next_part++;
+        parallel_job job = pool_job;
+        pthread_mutex_unlock(&pool_lock);
+        run_part(&job, part);
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_pending == 0) {
+            pthread_cond_signal(&pool_done);
+        }
+    }
+}
+
+static void* pool_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_lock);
+    unsigned long seen = pool_generation;
+    for (;;) {
+        while (!pool_stop && pool_generation == seen) {
+            pthread_cond_wait(&pool_work, &pool_lock);
+        }
+        if (pool_stop) break;
+        seen = pool_generation;
+        drain_parts();
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+// 以下两个函数要求调用者持有 pool_call_lock
+static void pool_stop_locked(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_stop = 1;
+    pthread_cond_broadcast(&pool_work);
+    pthread_mutex_unlock(&pool_lock);
+    
+    for (unsigned i = 0; i < pool_nworkers; i++) {
+        pthread_join(pool_threads[i], NULL);
+    }
+    free(pool_threads);
+    pool_threads = NULL;
+    pool_nworkers = 0;
+    pool_stop = 0;
+    pool_started = 0;
+}
+
+static int pool_start_locked(unsigned nthreads) {
+    if (nthreads == 0) nthreads = online_cpus();
+    pool_started = 1;
+    if (nthreads <= 1) return 0;
+    
+    pool_threads = (pthread_t*)malloc(sizeof(pthread_t) * (nthreads - 1));
+    if (pool_threads == NULL) return -1;
+    for (unsigned i = 0; i < nthreads - 1; i++) {
+        if (pthread_create(&pool_threads[i], NULL, pool_worker, NULL) != 0) {
+            // 回收已创建的线程，线程池保持为空，之后的拷贝退回串行
+            pool_stop_locked();
+            pool_started = 1;
+            return -1;
+        }
+        pool_nworkers++;
+    }
+    return 0;
+}
+
+int bitcpy_parallel_init(unsigned nthreads) {
+    pthread_mutex_lock(&pool_call_lock);
+    pool_stop_locked();
+    int ret = pool_start_locked(nthreads);
+    pthread_mutex_unlock(&pool_call_lock);
+    return ret;
+}
+
+void bitcpy_parallel_set_threshold(uint64_t min_bits) {
+    pool_threshold = min_bits;
+}
+
+void bitcpy_parallel_shutdown(void) {
+    pthread_mutex_lock(&pool_call_lock);
+    pool_stop_locked();
+    pthread_mutex_unlock(&pool_call_lock);
+}
+
+void bitcpy_parallel(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    // len == 0 时与 bitcpy() 一样立即返回，不启动线程池（阈值可能为 0）
+    if (len == 0 || len < pool_threshold) {
+        bitcpy(dest, dest_bit, src, src_bit, len);
+        return;
+    }
+    
+    pthread_mutex_lock(&pool_call_lock);
+    if (!pool_started) {
+        pool_start_locked(0);
+    }
+    if (pool_nworkers == 0) {
+        pthread_mutex_unlock(&pool_call_lock);
+        bitcpy(dest, dest_bit, src, src_bit, len);
+        return;
+    }
+    
+    // 块大小：按线程数均分后向上取整到缓存行，块边界对齐到目标地址的 64 字节边界
+    parallel_job job;
+    job.dest = dest;
+    job.src = src;
+    job.src_bit = src_bit;
+    job.origin = (uint64_t)((uintptr_t)dest & 63) << 3;
+    job.begin = job.origin + dest_bit;
+    job.end = job.begin + len;
+    uint64_t target_parts = (uint64_t)(pool_nworkers + 1) * PARALLEL_PARTS_PER_THREAD;
+    uint64_t chunk = (job.end + target_parts - 1) / target_parts;
+    job.chunk_bits = (chunk + PARALLEL_LINE_BITS - 1) / PARALLEL_LINE_BITS * PARALLEL_LINE_BITS;
+    job.nparts = (job.end + job.chunk_bits - 1) / job.chunk_bits;
+    
+    pthread_mutex_lock(&pool_lock);
+    pool_job = job;
+    pool_next_part = job.begin / job.chunk_bits;  // 跳过完全位于起点之前的块
+    pool_pending = job.nparts - pool_next_part;
+    pool_generation++;
+    pthread_cond_broadcast(&pool_work);
+    
+    // 调用线程也参与拷贝，然后等待其他线程完成已领取的块
+    drain_parts();
+    while (pool_pending != 0) {
+        pthread_cond_wait(&pool_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&pool_call_lock);
+}
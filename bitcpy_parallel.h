@@ -0,0 +1,57 @@
+#ifndef BITCPY_PARALLEL_H
+#define BITCPY_PARALLEL_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 配置并启动常驻线程池
+ * @param nthreads  参与拷贝的线程总数（含调用线程），0 表示使用在线 CPU 数
+ * @return 0 成功，-1 创建线程失败（此时线程池为空，bitcpy_parallel 退回串行）
+ *
+ * 可以重复调用以调整线程数：等待正在执行的并行拷贝结束，停止旧的线程池再创建新的。
+ * 不调用时，第一次达到阈值的 bitcpy_parallel() 会按 CPU 数自动创建线程池。
+ */
+int bitcpy_parallel_init(unsigned nthreads);
+
+/**
+ * @brief 设置并行阈值
+ * @param min_bits  len 小于该位数时 bitcpy_parallel() 直接调用 bitcpy()，默认 1 << 25（4 MiB）
+ *
+ * 应在发出并行拷贝之前设置，不要与 bitcpy_parallel() 并发调用。
+ */
+void bitcpy_parallel_set_threshold(uint64_t min_bits);
+
+/**
+ * @brief 停止并回收线程池中的所有线程
+ */
+void bitcpy_parallel_shutdown(void);
+
+/**
+ * @brief 多线程位级内存拷贝
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param src       源缓冲区（指向起始字节）
+ * @param src_bit   源起始位偏移（0-7）
+ * @param len       要拷贝的位数
+ *
+ * 参数要求与 bitcpy() 相同，另外源区间和目标区间不能重叠。结果与 bitcpy() 逐位一致。
+ *
+ * === 划分策略 ===
+ * - len 小于阈值或线程池只有一个线程时，直接调用 bitcpy()
+ * - 否则把目标区间按 64 字节对齐的地址边界切成若干块，每个线程每次领取一块，
+ *   对块调用 bitcpy()：块边界都落在目标的缓存行边界上，线程之间不会共享目标字节，
+ *   也不会在目标缓存行上伪共享；只有首块保留 dest_bit，末块保留尾部的 1-7 位
+ * - 调用线程也参与拷贝，所有块完成后才返回
+ * - 同一时刻只执行一个并行拷贝，多个线程同时调用时依次执行
+ */
+void bitcpy_parallel(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITCPY_PARALLEL_H
@@ -0,0 +1,51 @@
+#ifndef BITCPY_SIMD_H
+#define BITCPY_SIMD_H
+
+#include <stdint.h>
+
+/*
+ * 内部头文件：各模块 SIMD 内核共用的编译条件，不属于公开接口。
+ *
+ * - BITCPY_X86_SIMD：GCC/Clang 编译 x86 目标且未定义 BITCPY_NO_SIMD 时为 1。
+ *   此时各模块用 __attribute__((target(...))) 编译各指令集的内核，
+ *   首次调用时通过 CPUID（__builtin_cpu_supports）选定一次；否则只编译标量实现。
+ * - BITCPY_PREFETCH(addr, rw)：软件预取，rw 为 0 表示读、1 表示写。
+ * - bitcpy_funnel_load128/256/512()：阶段2内核的移位拼接读取，见下。
+ */
+#if !defined(BITCPY_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITCPY_X86_SIMD 1
+#include <immintrin.h>
+
+// 漏斗移位读取：返回从 p 起 16/32/64 字节整体右移 shift 位（0-7）的结果，最高字节的高位由下一字节补齐：
+//   (load(p) >> shift) | (load(p + 1) << (8 - shift))   （按 64 位通道移位）
+// 两次读取错开 1 字节，使每个 64 位通道的高 shift 位恰好由下一字节补齐；shift == 0 时两部分相同。
+// 共读取向量宽度 + 1 字节。rs/ls 分别为装入 __m128i 的 shift 和 8 - shift。
+__attribute__((target("sse2")))
+static inline __m128i bitcpy_funnel_load128(const uint8_t* p, __m128i rs, __m128i ls) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)p);
+    __m128i hi = _mm_loadu_si128((const __m128i*)(p + 1));
+    return _mm_or_si128(_mm_srl_epi64(lo, rs), _mm_sll_epi64(hi, ls));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i bitcpy_funnel_load256(const uint8_t* p, __m128i rs, __m128i ls) {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 1));
+    return _mm256_or_si256(_mm256_srl_epi64(lo, rs), _mm256_sll_epi64(hi, ls));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i bitcpy_funnel_load512(const uint8_t* p, __m128i rs, __m128i ls) {
+    __m512i lo = _mm512_loadu_si512((const void*)p);
+    __m512i hi = _mm512_loadu_si512((const void*)(p + 1));
+    return _mm512_or_si512(_mm512_srl_epi64(lo, rs), _mm512_sll_epi64(hi, ls));
+}
+#endif
+
+#if defined(__GNUC__)
+#define BITCPY_PREFETCH(addr, rw) __builtin_prefetch((addr), (rw), 3)
+#else
+#define BITCPY_PREFETCH(addr, rw) ((void)(addr))
+#endif
+
+#endif // BITCPY_SIMD_H
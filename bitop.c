@@ -0,0 +1,424 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitop.h"
+#include "bitcpy_simd.h"
+
+// 运算常量：result = (a & b & k[0]) ^ ((a ^ b) & k[1]) ^ k[2]
+static void bitop_consts(bitop_kind op, uint64_t k[3]) {
+    k[0] = k[1] = k[2] = 0;
+    switch (op) {
+    case BITOP_AND: k[0] = ~(uint64_t)0; break;
+    case BITOP_OR:  k[0] = k[1] = ~(uint64_t)0; break;
+    case BITOP_XOR: k[1] = ~(uint64_t)0; break;
+    case BITOP_NOT: k[0] = k[2] = ~(uint64_t)0; break;  // b == a 时 a & b == a
+    }
+}
+
+static inline uint64_t bitop_combine(uint64_t a, uint64_t b, const uint64_t k[3]) {
+    return ((a & b) & k[0]) ^ ((a ^ b) & k[1]) ^ k[2];
+}
+
+// 读取从 p 第 bit 位开始的 n 位（1-8），源数据可能跨两个字节
+static inline uint8_t load_bits8(const uint8_t* p, unsigned bit, unsigned n) {
+    uint16_t v = p[0];
+    if (bit + n > 8) {
+        v |= (uint16_t)p[1] << 8;
+    }
+    return (uint8_t)(v >> bit);
+}
+
+// 读取从 p 第 bit 位开始的 64 位；bit != 0 时读取 9 字节
+static inline uint64_t load_bits64(const uint8_t* p, unsigned bit) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    if (bit != 0) {
+        v = (v >> bit) | ((uint64_t)p[8] << (64 - bit));
+    }
+    return v;
+}
+
+/*
+ * === 阶段2 SIMD 内核 ===
+ * 两个操作数各自用 bitcpy_funnel_load*() 移位拼接（位偏移为 0 时结果不变），
+ * 运算后整向量写入 dest。输出 n 字节时每个操作数读取 n + 1 字节，调用者据此限制 n。
+ * 返回已处理的字节数，剩余部分交给标量循环。
+ */
+#ifdef BITCPY_X86_SIMD
+
+// 少于该位数时直接走标量循环，避免间接调用的开销
+#define BITOP_SIMD_MIN_BITS 256
+
+typedef size_t (*bitop_kernel_fn)(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                  const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n);
+
+__attribute__((target("sse2")))
+static size_t bitop_kernel_sse2(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n) {
+    const __m128i ars = _mm_cvtsi32_si128((int)sa), als = _mm_cvtsi32_si128((int)(8 - sa));
+    const __m128i brs = _mm_cvtsi32_si128((int)sb), bls = _mm_cvtsi32_si128((int)(8 - sb));
+    const __m128i k0 = _mm_set1_epi64x((long long)k[0]);
+    const __m128i k1 = _mm_set1_epi64x((long long)k[1]);
+    const __m128i k2 = _mm_set1_epi64x((long long)k[2]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = bitcpy_funnel_load128(a + i, ars, als);
+        __m128i y = bitcpy_funnel_load128(b + i, brs, bls);
+        __m128i r = _mm_xor_si128(_mm_and_si128(_mm_and_si128(x, y), k0),
+                                  _mm_xor_si128(_mm_and_si128(_mm_xor_si128(x, y), k1), k2));
+        _mm_storeu_si128((__m128i*)(dest + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t bitop_kernel_avx2(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n) {
+    const __m128i ars = _mm_cvtsi32_si128((int)sa), als = _mm_cvtsi32_si128((int)(8 - sa));
+    const __m128i brs = _mm_cvtsi32_si128((int)sb), bls = _mm_cvtsi32_si128((int)(8 - sb));
+    const __m256i k0 = _mm256_set1_epi64x((long long)k[0]);
+    const __m256i k1 = _mm256_set1_epi64x((long long)k[1]);
+    const __m256i k2 = _mm256_set1_epi64x((long long)k[2]);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = bitcpy_funnel_load256(a + i, ars, als);
+        __m256i y = bitcpy_funnel_load256(b + i, brs, bls);
+        __m256i r = _mm256_xor_si256(_mm256_and_si256(_mm256_and_si256(x, y), k0),
+                                     _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(x, y), k1), k2));
+        _mm256_storeu_si256((__m256i*)(dest + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t bitop_kernel_avx512(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                  const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n) {
+    const __m128i ars = _mm_cvtsi32_si128((int)sa), als = _mm_cvtsi32_si128((int)(8 - sa));
+    const __m128i brs = _mm_cvtsi32_si128((int)sb), bls = _mm_cvtsi32_si128((int)(8 - sb));
+    const __m512i k0 = _mm512_set1_epi64((long long)k[0]);
+    const __m512i k1 = _mm512_set1_epi64((long long)k[1]);
+    const __m512i k2 = _mm512_set1_epi64((long long)k[2]);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i x = bitcpy_funnel_load512(a + i, ars, als);
+        __m512i y = bitcpy_funnel_load512(b + i, brs, bls);
+        __m512i r = _mm512_xor_si512(_mm512_and_si512(_mm512_and_si512(x, y), k0),
+                                     _mm512_xor_si512(_mm512_and_si512(_mm512_xor_si512(x, y), k1), k2));
+        _mm512_storeu_si512((void*)(dest + i), r);
+    }
+    return i;
+}
+
+static size_t bitop_kernel_none(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n) {
+    (void)dest; (void)a; (void)sa; (void)b; (void)sb; (void)k; (void)n;
+    return 0;
+}
+
+static size_t bitop_kernel_resolve(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                   const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n);
+static bitop_kernel_fn bitop_kernel = bitop_kernel_resolve;
+
+// 首次调用时选择内核；多线程同时初始化只会写入相同的值
+static size_t bitop_kernel_resolve(uint8_t* dest, const uint8_t* a, unsigned sa,
+                                   const uint8_t* b, unsigned sb, const uint64_t k[3], size_t n) {
+    bitop_kernel_fn fn = bitop_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        fn = bitop_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = bitop_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = bitop_kernel_sse2;
+    }
+    bitop_kernel = fn;
+    return fn(dest, a, sa, b, sb, k, n);
+}
+#endif
+
+void bitop(uint8_t* dest, uint8_t dest_bit, const uint8_t* a, uint8_t a_bit,
+           const uint8_t* b, uint8_t b_bit, uint64_t len, bitop_kind op) {
+    if (len == 0) return;
+    uint64_t k[3];
+    bitop_consts(op, k);
+    if (op == BITOP_NOT) {
+        b = a;
+        b_bit = a_bit;
+    }
+    uint64_t remaining = len;
+    
+    // 阶段1：处理前导位，使目标对齐到字节边界
+    if (dest_bit != 0) {
+        unsigned n = 8 - dest_bit;
+        if (n > remaining) n = (unsigned)remaining;
+        uint8_t v = (uint8_t)bitop_combine(load_bits8(a, a_bit, n), load_bits8(b, b_bit, n), k);
+        uint8_t write_mask = (uint8_t)(((1u << n) - 1) << dest_bit);
+        dest[0] = (uint8_t)((dest[0] & ~write_mask) | ((v << dest_bit) & write_mask));
+        
+        remaining -= n;
+        if (remaining == 0) return;
+        dest++;
+        a += (a_bit + n) >> 3;
+        a_bit = (a_bit + n) & 7;
+        b += (b_bit + n) >> 3;
+        b_bit = (b_bit + n) & 7;
+    }
+    
+    // 阶段2：64位块处理
+#ifdef BITCPY_X86_SIMD
+    if (remaining >= BITOP_SIMD_MIN_BITS) {
+        // 内核每个操作数多读 1 字节：输出字节数不能超过可读字节数 - 1
+        size_t n = (size_t)(remaining >> 3);
+        size_t a_limit = (size_t)((a_bit + remaining + 7) >> 3) - 1;
+        size_t b_limit = (size_t)((b_bit + remaining + 7) >> 3) - 1;
+        if (n > a_limit) n = a_limit;
+        if (n > b_limit) n = b_limit;
+        size_t done = bitop_kernel(dest, a, a_bit, b, b_bit, k, n);
+        dest += done;
+        a += done;
+        b += done;
+        remaining -= (uint64_t)done << 3;
+    }
+#endif
+    // 非对齐的操作数需要读取 9 字节，刚好剩 64 位时退回字节处理（与 bitcpy() 相同）
+    while (remaining > 64 || (remaining == 64 && (a_bit | b_bit) == 0)) {
+        uint64_t v = bitop_combine(load_bits64(a, a_bit), load_bits64(b, b_bit), k);
+        memcpy(dest, &v, 8);
+        dest += 8;
+        a += 8;
+        b += 8;
+        remaining -= 64;
+    }
+    
+    // 阶段3：字节级处理
+    while (remaining >= 8) {
+        *dest = (uint8_t)bitop_combine(load_bits8(a, a_bit, 8), load_bits8(b, b_bit, 8), k);
+        dest++;
+        a++;
+        b++;
+        remaining -= 8;
+    }
+    
+    // 阶段4：剩余位（1-7位），保留目标高位
+    if (remaining > 0) {
+        unsigned n = (unsigned)remaining;
+        uint8_t v = (uint8_t)bitop_combine(load_bits8(a, a_bit, n), load_bits8(b, b_bit, n), k);
+        uint8_t write_mask = (uint8_t)((1u << n) - 1);
+        dest[0] = (uint8_t)((dest[0] & ~write_mask) | (v & write_mask));
+    }
+}
+
+/*
+ * === 二维位块传送 ===
+ * 光栅运算统一为 (d & s & k0) ^ (d & k1) ^ (s & k2)：
+ * COPY = s，AND = d & s，OR = (d & s) ^ d ^ s，XOR = d ^ s，ANDNOT = (d & s) ^ d。
+ */
+#define BLIT_PREFETCH_ROWS 4             // 预取几行之后的数据
+#define BLIT_PREFETCH_MAX_BYTES 1024     // 行宽超过该字节数时交给硬件预取
+#define BLIT_PREFETCH_MIN_SPAN (64u << 10)  // 矩形跨越的地址范围小于该值时通常已在缓存中，不预取
+
+static void blit_consts(bitblit_rop rop, uint64_t k[3]) {
+    k[0] = k[1] = k[2] = 0;
+    switch (rop) {
+    case BITBLIT_COPY:   k[2] = ~(uint64_t)0; break;
+    case BITBLIT_AND:    k[0] = ~(uint64_t)0; break;
+    case BITBLIT_OR:     k[0] = k[1] = k[2] = ~(uint64_t)0; break;
+    case BITBLIT_XOR:    k[1] = k[2] = ~(uint64_t)0; break;
+    case BITBLIT_ANDNOT: k[0] = k[1] = ~(uint64_t)0; break;
+    }
+}
+
+// 常量按值传入：经 k[] 读取时，每次通过 uint8_t* 写目标后编译器都要重新读取
+static inline uint64_t blit_combine(uint64_t d, uint64_t s, uint64_t k0, uint64_t k1, uint64_t k2) {
+    return (d & s & k0) ^ (d & k1) ^ (s & k2);
+}
+
+#ifdef BITCPY_X86_SIMD
+
+// 行体少于该字节数时直接走标量循环，避免间接调用的开销
+#define BLIT_SIMD_MIN_BYTES 32
+
+// 处理一行的行体：dest 已对齐到字节，源从 src 第 ss 位起；只读源时（COPY）不读取目标
+typedef size_t (*blit_kernel_fn)(uint8_t* dest, const uint8_t* src, unsigned ss,
+                                 const uint64_t k[3], size_t n);
+
+__attribute__((target("sse2")))
+static size_t blit_kernel_sse2(uint8_t* dest, const uint8_t* src, unsigned ss,
+                               const uint64_t k[3], size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)ss), ls = _mm_cvtsi32_si128((int)(8 - ss));
+    size_t i = 0;
+    if (k[0] == 0 && k[1] == 0) {
+        for (; i + 16 <= n; i += 16) {
+            _mm_storeu_si128((__m128i*)(dest + i), bitcpy_funnel_load128(src + i, rs, ls));
+        }
+        return i;
+    }
+    const __m128i k0 = _mm_set1_epi64x((long long)k[0]);
+    const __m128i k1 = _mm_set1_epi64x((long long)k[1]);
+    const __m128i k2 = _mm_set1_epi64x((long long)k[2]);
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = bitcpy_funnel_load128(src + i, rs, ls);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i r = _mm_xor_si128(_mm_and_si128(_mm_and_si128(d, s), k0),
+                                  _mm_xor_si128(_mm_and_si128(d, k1), _mm_and_si128(s, k2)));
+        _mm_storeu_si128((__m128i*)(dest + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t blit_kernel_avx2(uint8_t* dest, const uint8_t* src, unsigned ss,
+                               const uint64_t k[3], size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)ss), ls = _mm_cvtsi32_si128((int)(8 - ss));
+    size_t i = 0;
+    if (k[0] == 0 && k[1] == 0) {
+        for (; i + 32 <= n; i += 32) {
+            _mm256_storeu_si256((__m256i*)(dest + i), bitcpy_funnel_load256(src + i, rs, ls));
+        }
+        return i;
+    }
+    const __m256i k0 = _mm256_set1_epi64x((long long)k[0]);
+    const __m256i k1 = _mm256_set1_epi64x((long long)k[1]);
+    const __m256i k2 = _mm256_set1_epi64x((long long)k[2]);
+    for (; i + 32 <= n; i += 32) {
+        __m256i s = bitcpy_funnel_load256(src + i, rs, ls);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        __m256i r = _mm256_xor_si256(_mm256_and_si256(_mm256_and_si256(d, s), k0),
+                                     _mm256_xor_si256(_mm256_and_si256(d, k1), _mm256_and_si256(s, k2)));
+        _mm256_storeu_si256((__m256i*)(dest + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t blit_kernel_avx512(uint8_t* dest, const uint8_t* src, unsigned ss,
+                                 const uint64_t k[3], size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)ss), ls = _mm_cvtsi32_si128((int)(8 - ss));
+    size_t i = 0;
+    if (k[0] == 0 && k[1] == 0) {
+        for (; i + 64 <= n; i += 64) {
+            _mm512_storeu_si512((void*)(dest + i), bitcpy_funnel_load512(src + i, rs, ls));
+        }
+        return i;
+    }
+    const __m512i k0 = _mm512_set1_epi64((long long)k[0]);
+    const __m512i k1 = _mm512_set1_epi64((long long)k[1]);
+    const __m512i k2 = _mm512_set1_epi64((long long)k[2]);
+    for (; i + 64 <= n; i += 64) {
+        __m512i s = bitcpy_funnel_load512(src + i, rs, ls);
+        __m512i d = _mm512_loadu_si512((const void*)(dest + i));
+        __m512i r = _mm512_xor_si512(_mm512_and_si512(_mm512_and_si512(d, s), k0),
+                                     _mm512_xor_si512(_mm512_and_si512(d, k1), _mm512_and_si512(s, k2)));
+        _mm512_storeu_si512((void*)(dest + i), r);
+    }
+    return i;
+}
+
+static size_t blit_kernel_none(uint8_t* dest, const uint8_t* src, unsigned ss,
+                               const uint64_t k[3], size_t n) {
+    (void)dest; (void)src; (void)ss; (void)k; (void)n;
+    return 0;
+}
+
+static size_t blit_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned ss,
+                                  const uint64_t k[3], size_t n);
+static blit_kernel_fn blit_kernel = blit_kernel_resolve;
+
+// 首次调用时选择内核；多线程同时初始化只会写入相同的值
+static size_t blit_kernel_resolve(uint8_t* dest, const uint8_t* src, unsigned ss,
+                                  const uint64_t k[3], size_t n) {
+    blit_kernel_fn fn = blit_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        fn = blit_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = blit_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = blit_kernel_sse2;
+    }
+    blit_kernel = fn;
+    return fn(dest, src, ss, k, n);
+}
+#endif
+
+void bitblit(uint8_t* dst, size_t dst_stride, uint64_t dst_x,
+             const uint8_t* src, size_t src_stride, uint64_t src_x,
+             uint64_t width, uint64_t height, bitblit_rop rop) {
+    if (width == 0 || height == 0) return;
+    uint64_t k[3];
+    blit_consts(rop, k);
+    const uint64_t k0 = k[0], k1 = k[1], k2 = k[2];
+    dst += dst_x >> 3;
+    src += src_x >> 3;
+
+    // 每行相同的布局：首字节、行体（向量 + 64 位 + 字节）、尾字节
+    unsigned dest_bit = (unsigned)(dst_x & 7);
+    unsigned src_bit = (unsigned)(src_x & 7);
+    unsigned head = 0;
+    uint8_t head_mask = 0;
+    if (dest_bit != 0) {
+        head = 8 - dest_bit;
+        if (head > width) head = (unsigned)width;
+        head_mask = (uint8_t)(((1u << head) - 1) << dest_bit);
+    }
+    size_t body_src = (src_bit + head) >> 3;  // 行体的源相对行起点的字节偏移
+    unsigned body_bit = (src_bit + head) & 7;
+    uint64_t body = width - head;
+    size_t body_bytes = (size_t)(body >> 3);
+    unsigned tail = (unsigned)(body & 7);
+    uint8_t tail_mask = (uint8_t)((1u << tail) - 1);
+    // 向量内核和 64 位循环都会多读 1 个源字节：行体输出的字节数不能超过行体可读的源字节数 - 1
+    size_t body_readable = (size_t)((body_bit + body + 7) >> 3);
+    size_t vec_bytes = body_bytes < body_readable - 1 ? body_bytes : body_readable - 1;
+    size_t word_bytes = body_bit == 0 ? body_bytes : vec_bytes;
+#ifdef BITCPY_X86_SIMD
+    if (vec_bytes < BLIT_SIMD_MIN_BYTES) vec_bytes = 0;
+#endif
+    size_t row_bytes = (size_t)((dest_bit + width + 7) >> 3);
+    size_t max_stride = dst_stride > src_stride ? dst_stride : src_stride;
+    int prefetch = row_bytes <= BLIT_PREFETCH_MAX_BYTES && height * max_stride >= BLIT_PREFETCH_MIN_SPAN;
+
+    for (uint64_t y = 0; y < height; y++) {
+        uint8_t* d = dst + y * dst_stride;
+        const uint8_t* s = src + y * src_stride;
+        if (prefetch && y + BLIT_PREFETCH_ROWS < height) {
+            const uint8_t* ps = s + BLIT_PREFETCH_ROWS * src_stride;
+            uint8_t* pd = d + BLIT_PREFETCH_ROWS * dst_stride;
+            for (size_t off = 0; off < row_bytes; off += 64) {
+                BITCPY_PREFETCH(ps + off, 0);
+                BITCPY_PREFETCH(pd + off, 1);
+            }
+        }
+
+        if (head != 0) {
+            uint8_t v = (uint8_t)(load_bits8(s, src_bit, head) << dest_bit);
+            uint8_t r = (uint8_t)blit_combine(d[0], v, k0, k1, k2);
+            d[0] = (uint8_t)((d[0] & ~head_mask) | (r & head_mask));
+            d++;
+        }
+        s += body_src;
+
+        size_t i = 0;
+#ifdef BITCPY_X86_SIMD
+        if (vec_bytes != 0) {
+            i = blit_kernel(d, s, body_bit, k, vec_bytes);
+        }
+#endif
+        for (; i + 8 <= word_bytes; i += 8) {
+            uint64_t dv;
+            memcpy(&dv, d + i, 8);
+            dv = blit_combine(dv, load_bits64(s + i, body_bit), k0, k1, k2);
+            memcpy(d + i, &dv, 8);
+        }
+        for (; i < body_bytes; i++) {
+            d[i] = (uint8_t)blit_combine(d[i], load_bits8(s + i, body_bit, 8), k0, k1, k2);
+        }
+        if (tail != 0) {
+            uint8_t r = (uint8_t)blit_combine(d[i], load_bits8(s + i, body_bit, tail), k0, k1, k2);
+            d[i] = (uint8_t)((d[i] & ~tail_mask) | (r & tail_mask));
+        }
+    }
+}
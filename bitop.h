@@ -0,0 +1,101 @@
+#ifndef BITOP_H
+#define BITOP_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 位区间逻辑运算的种类
+ */
+typedef enum {
+    BITOP_AND,  // dest = a & b
+    BITOP_OR,   // dest = a | b
+    BITOP_XOR,  // dest = a ^ b
+    BITOP_NOT,  // dest = ~a，忽略 b 和 b_bit（b 可以为 NULL）
+} bitop_kind;
+
+/**
+ * @brief 对两个起始位偏移各不相同的位区间做逻辑运算，结果写入第三个位区间
+ * @param dest      目标缓冲区（指向起始字节）
+ * @param dest_bit  目标起始位偏移（0-7）
+ * @param a         第一个操作数（指向起始字节）
+ * @param a_bit     第一个操作数的起始位偏移（0-7）
+ * @param b         第二个操作数（指向起始字节），op 为 BITOP_NOT 时不使用
+ * @param b_bit     第二个操作数的起始位偏移（0-7）
+ * @param len       位数
+ * @param op        运算种类
+ *
+ * 结果等价于先把 a、b 分别 bitcpy() 到对齐的临时缓冲区，逐字节运算后再 bitcpy() 到 dest，
+ * 但只读写一遍数据，不使用临时缓冲区。位序与 bitcpy() 相同。
+ *
+ * === 参数要求（调用者保证） ===
+ * - 各缓冲区至少需要 (bit + len + 7) / 8 字节，只访问这些字节；dest 中区间之外的位保持不变
+ * - dest 可以与 a 或 b 是同一位区间（原地运算，如 a &= b）；
+ *   其他重叠与 bitcpy() 相同，只有目标位地址不高于操作数位地址时结果才正确
+ *
+ * === 底层优化策略 ===
+ * 沿用 bitcpy() 的阶段划分，两个操作数各自按自己的位偏移移位拼接：
+ * 1. 阶段1：处理 dest 的前导 1-7 位，使目标对齐到字节边界
+ * 2. 阶段2：每次从两个操作数各取 64 位（8 字节 + 1 字节拼接）运算后整字写入；
+ *    剩余 >= 256 位时先由 SIMD 内核每步处理 16/32/64 字节（与 bitcpy() 阶段2内核相同的移位拼接），
+ *    内核在首次调用时按 CPUID 选定（AVX-512 > AVX2 > SSE2），定义 BITCPY_NO_SIMD 可关闭
+ * 3. 阶段3/4：字节和剩余位，末字节带掩码写入
+ * 四种运算统一为 (a & b & k0) ^ ((a ^ b) & k1) ^ k2（BITOP_NOT 时 b 取 a），循环内没有分支。
+ */
+void bitop(uint8_t* dest, uint8_t dest_bit, const uint8_t* a, uint8_t a_bit,
+           const uint8_t* b, uint8_t b_bit, uint64_t len, bitop_kind op);
+
+/**
+ * @brief 二维位块传送的光栅运算，dst 为目标原值、src 为源
+ */
+typedef enum {
+    BITBLIT_COPY,    // dst = src
+    BITBLIT_AND,     // dst &= src
+    BITBLIT_OR,      // dst |= src
+    BITBLIT_XOR,     // dst ^= src
+    BITBLIT_ANDNOT,  // dst &= ~src
+} bitblit_rop;
+
+/**
+ * @brief 1 位/像素位图之间的矩形块传送
+ * @param dst         目标位图第 0 行的起始字节
+ * @param dst_stride  目标每行的字节数
+ * @param dst_x       目标矩形在每行中的起始位（不限于 0-7）
+ * @param src         源位图第 0 行的起始字节
+ * @param src_stride  源每行的字节数
+ * @param src_x       源矩形在每行中的起始位
+ * @param width       矩形宽度（位）
+ * @param height      矩形高度（行）
+ * @param rop         光栅运算
+ *
+ * 结果等价于对每一行 y 做一次位区间运算（BITBLIT_COPY 即 bitcpy()）：
+ *   行 y 的目标区间为 dst + y * dst_stride 第 dst_x 位起的 width 位，源区间同理；
+ * 目标矩形之外的位保持不变。位序与 bitcpy() 相同。
+ *
+ * === 参数要求（调用者保证） ===
+ * - 每行只访问矩形所在的字节，即从第 x / 8 字节起的 (x % 8 + width + 7) / 8 字节
+ * - 源矩形和目标矩形不能重叠
+ *
+ * === 底层优化策略 ===
+ * 两个位图的行步长都是整字节，因此每行的位偏移相同：移位量、首尾字节掩码、
+ * 向量部分的字节数在调用开始时算好一次，逐行执行时没有重新计算和分派。每行：
+ * - 首字节：目标起点不在字节边界时带掩码读-改-写
+ * - 行体：SIMD 内核每步 16/32/64 字节（源用与 bitcpy() 阶段2相同的漏斗移位读取，
+ *   与目标按 (d & s & k0) ^ (d & k1) ^ (s & k2) 合并，BITBLIT_COPY 不读取目标），
+ *   内核在首次调用时按 CPUID 选定（AVX-512 > AVX2 > SSE2），之后是 64 位和字节循环
+ * - 尾字节：带掩码读-改-写
+ * 行宽不超过 1 KiB 且矩形跨越的地址范围不小于 64 KiB 时，每行开始前预取 4 行之后的源行和目标行
+ * （行很窄而步长很大时硬件预取跟不上）；跨越范围更小的矩形（如单个字形）通常已在缓存中，不预取。
+ */
+void bitblit(uint8_t* dst, size_t dst_stride, uint64_t dst_x,
+             const uint8_t* src, size_t src_stride, uint64_t src_x,
+             uint64_t width, uint64_t height, bitblit_rop rop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITOP_H
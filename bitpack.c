@@ -0,0 +1,708 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitpack.h"
+#include "bitstream.h"
+#include "bitcpy_simd.h"
+#include <stdlib.h>
+
+#define PACK_SIMD_MIN_VALUES 64   // 少于该值数时建表的开销不划算
+#define PACK_SIMD_MAX_WIDTH 56    // 值加上组内移位（<= 7）要放得进 64 位通道
+
+// 标量路径：64 位累加器逐值读写
+static void pack_scalar(uint8_t* dest, unsigned dest_bit, const void* values, int elem64,
+                        size_t n, unsigned width) {
+    bitstream_writer w;
+    bitstream_writer_init(&w, dest, (uint8_t)dest_bit);
+    if (elem64) {
+        const uint64_t* v = (const uint64_t*)values;
+        for (size_t i = 0; i < n; i++) bitstream_put_bits(&w, v[i], width);
+    } else {
+        const uint32_t* v = (const uint32_t*)values;
+        for (size_t i = 0; i < n; i++) bitstream_put_bits(&w, v[i], width);
+    }
+    bitstream_writer_flush(&w);
+}
+
+static void unpack_scalar(void* values, int elem64, const uint8_t* src, unsigned src_bit,
+                          size_t n, unsigned width) {
+    bitstream_reader r;
+    bitstream_reader_init(&r, src, (uint8_t)src_bit, (uint64_t)n * width);
+    if (elem64) {
+        uint64_t* v = (uint64_t*)values;
+        for (size_t i = 0; i < n; i++) v[i] = bitstream_get_bits(&r, width);
+    } else {
+        uint32_t* v = (uint32_t*)values;
+        for (size_t i = 0; i < n; i++) v[i] = (uint32_t)bitstream_get_bits(&r, width);
+    }
+}
+
+#ifdef BITCPY_X86_SIMD
+enum { PACK_LEVEL_SCALAR, PACK_LEVEL_AVX2, PACK_LEVEL_VBMI };
+
+static int pack_level_cached = -1;
+
+// 一组 8 个值的布局：第 k 个值从组起点的第 o[k] 字节、第 t[k] 位开始
+typedef struct {
+    unsigned o[8];
+    unsigned t[8];
+    unsigned bytes;  // 一组覆盖的字节数（含与下一组共享的字节）
+} group_layout;
+
+static void group_layout_init(group_layout* g, unsigned bit, unsigned width) {
+    for (unsigned k = 0; k < 8; k++) {
+        unsigned pos = bit + k * width;
+        g->o[k] = pos >> 3;
+        g->t[k] = pos & 7;
+    }
+    g->bytes = (bit + 8 * width + 7) >> 3;
+}
+
+// 首次调用时检测一次；多线程同时初始化只会写入相同的值
+static int pack_level(void) {
+    if (pack_level_cached < 0) {
+        int level = PACK_LEVEL_SCALAR;
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vbmi")) {
+            level = PACK_LEVEL_VBMI;
+        } else if (__builtin_cpu_supports("avx2")) {
+            level = PACK_LEVEL_AVX2;
+        }
+        pack_level_cached = level;
+    }
+    return pack_level_cached;
+}
+
+// 解包：VPERMB 把第 k 个值起始的 8 个字节放到第 k 个 64 位通道，再按 t[k] 右移、按 width 掩码。
+// 每组只掩码读取 g.bytes 个字节，掩码之外的字节不会被访问。
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static size_t unpack_vbmi(void* values, int elem64, const uint8_t* src, unsigned src_bit,
+                          size_t n, unsigned width) {
+    group_layout g;
+    group_layout_init(&g, src_bit, width);
+    uint8_t idx_bytes[64];
+    for (unsigned k = 0; k < 8; k++) {
+        for (unsigned j = 0; j < 8; j++) idx_bytes[8 * k + j] = (uint8_t)(g.o[k] + j);
+    }
+    const __m512i idx = _mm512_loadu_si512((const void*)idx_bytes);
+    const __m512i shifts = _mm512_set_epi64(g.t[7], g.t[6], g.t[5], g.t[4],
+                                            g.t[3], g.t[2], g.t[1], g.t[0]);
+    const __m512i mask = _mm512_set1_epi64((long long)bitstream_mask(width));
+    const __mmask64 load_mask = ((__mmask64)1 << g.bytes) - 1;
+    size_t groups = n >> 3;
+
+    for (size_t i = 0; i < groups; i++) {
+        __m512i x = _mm512_maskz_loadu_epi8(load_mask, src + i * width);
+        __m512i y = _mm512_and_si512(_mm512_srlv_epi64(_mm512_permutexvar_epi8(idx, x), shifts), mask);
+        if (elem64) {
+            _mm512_storeu_si512((void*)((uint64_t*)values + i * 8), y);
+        } else {
+            _mm256_storeu_si256((__m256i*)((uint32_t*)values + i * 8), _mm512_cvtepi64_epi32(y));
+        }
+    }
+    return groups << 3;
+}
+
+// 打包：第 k 个值按 t[k] 左移后放在第 k 个 64 位通道，输出字节 b 由覆盖它的各通道字节 OR 而成。
+// 同一输出字节最多有 8 个值参与，按参与次序（rank）各做一次带掩码的 VPERMB。
+// 组的最后一个字节与下一组的第一个字节相同，作为进位并入下一组；每组只写前 width 个字节。
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static size_t pack_vbmi(uint8_t* dest, unsigned dest_bit, const void* values, int elem64,
+                        size_t n, unsigned width) {
+    group_layout g;
+    group_layout_init(&g, dest_bit, width);
+    uint8_t idx_bytes[8][64];
+    __mmask64 rank_mask[8] = {0};
+    uint8_t rank_count[64] = {0};
+    unsigned nranks = 0;
+    memset(idx_bytes, 0, sizeof(idx_bytes));
+    for (unsigned k = 0; k < 8; k++) {
+        unsigned last = g.o[k] + ((g.t[k] + width - 1) >> 3);
+        for (unsigned b = g.o[k]; b <= last; b++) {
+            unsigned r = rank_count[b]++;
+            idx_bytes[r][b] = (uint8_t)(8 * k + b - g.o[k]);
+            rank_mask[r] |= (__mmask64)1 << b;
+            if (r + 1 > nranks) nranks = r + 1;
+        }
+    }
+    __m512i idx[8];
+    for (unsigned r = 0; r < nranks; r++) idx[r] = _mm512_loadu_si512((const void*)idx_bytes[r]);
+    const __m512i shifts = _mm512_set_epi64(g.t[7], g.t[6], g.t[5], g.t[4],
+                                            g.t[3], g.t[2], g.t[1], g.t[0]);
+    const __m512i mask = _mm512_set1_epi64((long long)bitstream_mask(width));
+    const __m512i carry_idx = _mm512_set1_epi8((char)width);
+    const __mmask64 store_mask = ((__mmask64)1 << width) - 1;
+    const uint8_t keep_low = (uint8_t)bitstream_mask(dest_bit);
+    // 首组的进位：目标起始字节中 dest_bit 以下需要保留的位
+    __m512i carry = _mm512_zextsi128_si512(_mm_cvtsi32_si128(dest[0] & keep_low));
+    size_t groups = n >> 3;
+
+    for (size_t i = 0; i < groups; i++) {
+        __m512i x;
+        if (elem64) {
+            x = _mm512_loadu_si512((const void*)((const uint64_t*)values + i * 8));
+        } else {
+            x = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i*)((const uint32_t*)values + i * 8)));
+        }
+        x = _mm512_sllv_epi64(_mm512_and_si512(x, mask), shifts);
+        __m512i out = carry;
+        for (unsigned r = 0; r < nranks; r++) {
+            out = _mm512_or_si512(out, _mm512_maskz_permutexvar_epi8(rank_mask[r], idx[r], x));
+        }
+        _mm512_mask_storeu_epi8(dest + i * width, store_mask, out);
+        carry = _mm512_maskz_permutexvar_epi8(1, carry_idx, out);
+    }
+
+    // 写回最后的进位：下一组起始字节中 dest_bit 以下的位（dest_bit == 0 时没有共享字节）
+    if (groups != 0 && dest_bit != 0) {
+        uint8_t* p = dest + groups * width;
+        uint8_t c = (uint8_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(carry));
+        *p = (uint8_t)((*p & ~keep_low) | c);
+    }
+    return groups << 3;
+}
+
+// AVX2 解包：每半组 4 个值，128 位通道 l 从第 2l 个值的起始字节读取 16 字节，
+// VPSHUFB 把两个值各自的 8 字节放进 64 位通道。每组最远读到 o[6] + 16 字节，
+// 只处理这一范围不越过源缓冲区的组。
+__attribute__((target("avx2")))
+static size_t unpack_avx2(void* values, int elem64, const uint8_t* src, unsigned src_bit,
+                          size_t n, unsigned width) {
+    group_layout g;
+    group_layout_init(&g, src_bit, width);
+    uint8_t shuf_bytes[2][32];
+    for (unsigned h = 0; h < 2; h++) {
+        for (unsigned l = 0; l < 2; l++) {
+            unsigned base = g.o[4 * h + 2 * l];
+            for (unsigned q = 0; q < 2; q++) {
+                unsigned k = 4 * h + 2 * l + q;
+                for (unsigned j = 0; j < 8; j++) {
+                    shuf_bytes[h][16 * l + 8 * q + j] = (uint8_t)(g.o[k] - base + j);
+                }
+            }
+        }
+    }
+    const __m256i shuf[2] = {
+        _mm256_loadu_si256((const __m256i*)shuf_bytes[0]),
+        _mm256_loadu_si256((const __m256i*)shuf_bytes[1]),
+    };
+    const __m256i shifts[2] = {
+        _mm256_set_epi64x(g.t[3], g.t[2], g.t[1], g.t[0]),
+        _mm256_set_epi64x(g.t[7], g.t[6], g.t[5], g.t[4]),
+    };
+    const __m256i mask = _mm256_set1_epi64x((long long)bitstream_mask(width));
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    size_t src_bytes = (src_bit + (uint64_t)n * width + 7) >> 3;
+    size_t reach = g.o[6] + 16;
+    size_t groups = n >> 3;
+    size_t safe = src_bytes >= reach ? (src_bytes - reach) / width + 1 : 0;
+    if (groups > safe) groups = safe;
+
+    for (size_t i = 0; i < groups; i++) {
+        const uint8_t* p = src + i * width;
+        for (unsigned h = 0; h < 2; h++) {
+            __m256i v = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p + g.o[4 * h]))),
+                _mm_loadu_si128((const __m128i*)(p + g.o[4 * h + 2])), 1);
+            __m256i y = _mm256_and_si256(_mm256_srlv_epi64(_mm256_shuffle_epi8(v, shuf[h]), shifts[h]), mask);
+            if (elem64) {
+                _mm256_storeu_si256((__m256i*)((uint64_t*)values + i * 8 + 4 * h), y);
+            } else {
+                _mm_storeu_si128((__m128i*)((uint32_t*)values + i * 8 + 4 * h),
+                                 _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(y, even)));
+            }
+        }
+    }
+    return groups << 3;
+}
+#endif
+
+// 返回 SIMD 内核处理的值个数（8 的倍数），其余交给标量路径
+static size_t pack_simd(uint8_t* dest, unsigned dest_bit, const void* values, int elem64,
+                        size_t n, unsigned width) {
+#ifdef BITCPY_X86_SIMD
+    if (n >= PACK_SIMD_MIN_VALUES && width <= PACK_SIMD_MAX_WIDTH &&
+        pack_level() == PACK_LEVEL_VBMI) {
+        return pack_vbmi(dest, dest_bit, values, elem64, n, width);
+    }
+#else
+    (void)dest; (void)dest_bit; (void)values; (void)elem64; (void)n; (void)width;
+#endif
+    return 0;
+}
+
+static size_t unpack_simd(void* values, int elem64, const uint8_t* src, unsigned src_bit,
+                          size_t n, unsigned width) {
+#ifdef BITCPY_X86_SIMD
+    if (n >= PACK_SIMD_MIN_VALUES && width <= PACK_SIMD_MAX_WIDTH) {
+        switch (pack_level()) {
+        case PACK_LEVEL_VBMI: return unpack_vbmi(values, elem64, src, src_bit, n, width);
+        case PACK_LEVEL_AVX2: return unpack_avx2(values, elem64, src, src_bit, n, width);
+        default: break;
+        }
+    }
+#else
+    (void)values; (void)elem64; (void)src; (void)src_bit; (void)n; (void)width;
+#endif
+    return 0;
+}
+
+// 处理完 done 个值（8 的倍数）后，剩余部分的起点仍在同一位偏移上
+void bitpack32(uint8_t* dest, uint8_t dest_bit, const uint32_t* values, size_t n, unsigned width) {
+    size_t done = pack_simd(dest, dest_bit, values, 0, n, width);
+    pack_scalar(dest + (done >> 3) * width, dest_bit, values + done, 0, n - done, width);
+}
+
+void bitunpack32(uint32_t* values, const uint8_t* src, uint8_t src_bit, size_t n, unsigned width) {
+    size_t done = unpack_simd(values, 0, src, src_bit, n, width);
+    unpack_scalar(values + done, 0, src + (done >> 3) * width, src_bit, n - done, width);
+}
+
+void bitpack64(uint8_t* dest, uint8_t dest_bit, const uint64_t* values, size_t n, unsigned width) {
+    size_t done = pack_simd(dest, dest_bit, values, 1, n, width);
+    pack_scalar(dest + (done >> 3) * width, dest_bit, values + done, 1, n - done, width);
+}
+
+void bitunpack64(uint64_t* values, const uint8_t* src, uint8_t src_bit, size_t n, unsigned width) {
+    size_t done = unpack_simd(values, 1, src, src_bit, n, width);
+    unpack_scalar(values + done, 1, src + (done >> 3) * width, src_bit, n - done, width);
+}
+
+/*
+ * === 位与字节数组的展开/压缩 ===
+ * 两个方向都先用标量处理位区间起点所在的不完整字节，使位缓冲区一侧字节对齐；
+ * 之后内核每处理 1 个位字节对应 8 个数组字节，返回已处理的位字节数，
+ * 剩余的整字节和末尾 1-7 位由标量路径处理。内核在首次调用时按 CPUID 选定一次。
+ */
+
+// 把 b 的第 i 位散布到第 i 个字节的最低位（PDEP 的可移植版本）
+static inline uint64_t spread_byte(uint64_t b) {
+    b = (b | (b << 28)) & 0x0000000F0000000FULL;
+    b = (b | (b << 14)) & 0x0003000300030003ULL;
+    b = (b | (b << 7)) & 0x0101010101010101ULL;
+    return b;
+}
+
+// 8 个字节是否非 0，收集为 8 位（第 i 位对应第 i 个字节；PEXT 的可移植版本）
+static inline unsigned gather_nonzero(uint64_t x) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t t = (((x & low7) + low7) | x) & ~low7;  // 非 0 字节的最高位置 1
+    return (unsigned)(((t >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+typedef size_t (*expand_kernel_fn)(uint8_t* bytes, const uint8_t* src, size_t n);
+typedef size_t (*compact_kernel_fn)(uint8_t* dest, const uint8_t* bytes, size_t n);
+
+static size_t expand_kernel_none(uint8_t* bytes, const uint8_t* src, size_t n) {
+    (void)bytes; (void)src; (void)n;
+    return 0;
+}
+
+static size_t compact_kernel_none(uint8_t* dest, const uint8_t* bytes, size_t n) {
+    (void)dest; (void)bytes; (void)n;
+    return 0;
+}
+
+#ifdef BITCPY_X86_SIMD
+// AVX-512BW：每 8 个位字节直接作为 64 位写掩码，零掩码写入全 1 字节（VMOVDQU8，与 VPMOVM2B 再与 1 相同）
+__attribute__((target("avx512f,avx512bw")))
+static size_t expand_kernel_avx512(uint8_t* bytes, const uint8_t* src, size_t n) {
+    const __m512i ones = _mm512_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t m;
+        memcpy(&m, src + i, 8);
+        _mm512_storeu_si512((void*)(bytes + i * 8), _mm512_maskz_mov_epi8((__mmask64)m, ones));
+    }
+    return i;
+}
+
+// AVX2：把 4 个位字节广播到每个 128 位通道，VPSHUFB 把第 i 个位字节复制到第 8i..8i+7 个字节，
+// 再与各字节的位选择掩码比较
+__attribute__((target("avx2")))
+static size_t expand_kernel_avx2(uint8_t* bytes, const uint8_t* src, size_t n) {
+    const __m256i shuf = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                          2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i select = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    const __m256i ones = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t w;
+        memcpy(&w, src + i, 4);
+        __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32((int)w), shuf);
+        v = _mm256_cmpeq_epi8(_mm256_and_si256(v, select), select);
+        _mm256_storeu_si256((__m256i*)(bytes + i * 8), _mm256_and_si256(v, ones));
+    }
+    return i;
+}
+
+// BMI2：每个位字节 PDEP 散布到 8 个字节
+__attribute__((target("bmi2")))
+static size_t expand_kernel_bmi2(uint8_t* bytes, const uint8_t* src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = _pdep_u64(src[i], 0x0101010101010101ULL);
+        memcpy(bytes + i * 8, &v, 8);
+    }
+    return n;
+}
+
+// AVX-512BW：VPTESTMB 直接得到 64 个字节是否非 0 的掩码
+__attribute__((target("avx512f,avx512bw")))
+static size_t compact_kernel_avx512(uint8_t* dest, const uint8_t* bytes, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512((const void*)(bytes + i * 8));
+        uint64_t m = (uint64_t)_mm512_test_epi8_mask(v, v);
+        memcpy(dest + i, &m, 8);
+    }
+    return i;
+}
+
+// AVX2：与 0 比较后 VPMOVMSKB 取反
+__attribute__((target("avx2")))
+static size_t compact_kernel_avx2(uint8_t* dest, const uint8_t* bytes, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(bytes + i * 8));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(bytes + i * 8 + 32));
+        uint32_t mlo = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+        uint32_t mhi = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+        uint64_t m = mlo | ((uint64_t)mhi << 32);
+        memcpy(dest + i, &m, 8);
+    }
+    return i;
+}
+
+// BMI2：非 0 字节的最高位置 1 后 PEXT 收集
+__attribute__((target("bmi2")))
+static size_t compact_kernel_bmi2(uint8_t* dest, const uint8_t* bytes, size_t n) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x;
+        memcpy(&x, bytes + i * 8, 8);
+        uint64_t t = ((x & low7) + low7) | x;
+        dest[i] = (uint8_t)_pext_u64(t, ~low7);
+    }
+    return n;
+}
+
+static size_t expand_kernel_resolve(uint8_t* bytes, const uint8_t* src, size_t n);
+static size_t compact_kernel_resolve(uint8_t* dest, const uint8_t* bytes, size_t n);
+static expand_kernel_fn expand_kernel = expand_kernel_resolve;
+static compact_kernel_fn compact_kernel = compact_kernel_resolve;
+
+// 首次调用时检测一次；多线程同时初始化只会写入相同的函数指针
+static size_t expand_kernel_resolve(uint8_t* bytes, const uint8_t* src, size_t n) {
+    expand_kernel_fn fn = expand_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        fn = expand_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = expand_kernel_avx2;
+    } else if (__builtin_cpu_supports("bmi2")) {
+        fn = expand_kernel_bmi2;
+    }
+    expand_kernel = fn;
+    return fn(bytes, src, n);
+}
+
+static size_t compact_kernel_resolve(uint8_t* dest, const uint8_t* bytes, size_t n) {
+    compact_kernel_fn fn = compact_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        fn = compact_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = compact_kernel_avx2;
+    } else if (__builtin_cpu_supports("bmi2")) {
+        fn = compact_kernel_bmi2;
+    }
+    compact_kernel = fn;
+    return fn(dest, bytes, n);
+}
+#else
+static expand_kernel_fn expand_kernel = expand_kernel_none;
+static compact_kernel_fn compact_kernel = compact_kernel_none;
+#endif
+
+void bits_to_bytes(uint8_t* bytes, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    // 起点所在的不完整字节
+    if (src_bit != 0) {
+        uint64_t head = 8 - src_bit;
+        if (head > len) head = len;
+        for (uint64_t i = 0; i < head; i++) {
+            bytes[i] = (src[0] >> (src_bit + i)) & 1;
+        }
+        bytes += head;
+        src++;
+        len -= head;
+    }
+
+    size_t n = (size_t)(len >> 3);
+    size_t done = n != 0 ? expand_kernel(bytes, src, n) : 0;
+    for (size_t i = done; i < n; i++) {
+        uint64_t v = spread_byte(src[i]);
+        memcpy(bytes + i * 8, &v, 8);
+    }
+
+    // 末尾 1-7 位
+    unsigned rest = (unsigned)(len & 7);
+    for (unsigned i = 0; i < rest; i++) {
+        bytes[n * 8 + i] = (src[n] >> i) & 1;
+    }
+}
+
+void bytes_to_bits(uint8_t* dest, uint8_t dest_bit, const uint8_t* bytes, uint64_t len) {
+    if (len == 0) return;
+    // 起点所在的不完整字节：保留区间之外的位
+    if (dest_bit != 0) {
+        uint64_t head = 8 - dest_bit;
+        if (head > len) head = len;
+        uint8_t bits = 0;
+        for (uint64_t i = 0; i < head; i++) {
+            bits |= (uint8_t)((bytes[i] != 0) << (dest_bit + i));
+        }
+        uint8_t mask = (uint8_t)(((1u << head) - 1) << dest_bit);
+        dest[0] = (uint8_t)((dest[0] & ~mask) | bits);
+        bytes += head;
+        dest++;
+        len -= head;
+    }
+
+    size_t n = (size_t)(len >> 3);
+    size_t done = n != 0 ? compact_kernel(dest, bytes, n) : 0;
+    for (size_t i = done; i < n; i++) {
+        uint64_t x;
+        memcpy(&x, bytes + i * 8, 8);
+        dest[i] = (uint8_t)gather_nonzero(x);
+    }
+
+    // 末尾 1-7 位
+    unsigned rest = (unsigned)(len & 7);
+    if (rest != 0) {
+        uint8_t bits = 0;
+        for (unsigned i = 0; i < rest; i++) {
+            bits |= (uint8_t)((bytes[n * 8 + i] != 0) << i);
+        }
+        uint8_t mask = (uint8_t)((1u << rest) - 1);
+        dest[n] = (uint8_t)((dest[n] & ~mask) | bits);
+    }
+}
+
+#define PLAN_PIECE_BITS 57        // 源 8 字节读取右移至多 7 位后还剩 57 位
+#define PLAN_BITCPY_MIN_BITS 256  // 不少于该位数的段直接调用 bitcpy()
+
+// 一片：从源记录读取不超过 57 位，放到目标字中的 dst_shift 位起，不跨越目标字
+typedef struct {
+    uint64_t src_byte;
+    uint64_t mask;      // 低 len 位为 1
+    uint8_t src_shift;  // 0-7
+    uint8_t dst_shift;  // 0-63，相对目标字
+    uint8_t len;
+} plan_piece;
+
+// 一个目标字：记录中第 dst_byte 字节起的 nbytes 字节，由 npieces 个连续的片拼成后一次读-改-写
+typedef struct {
+    uint64_t dst_byte;
+    uint64_t mask;  // 字中被各片覆盖的位
+    size_t npieces;
+    size_t nbytes;  // 8；越过记录末尾的字只读写到 mask 的最高字节
+} plan_word;
+
+struct bitcpy_plan {
+    size_t src_stride;
+    size_t dst_stride;
+    size_t nwords;
+    size_t nlong;
+    size_t tail_records;  // 末尾这么多条记录的 8 字节读取可能越过缓冲区，逐段调用 bitcpy()
+    plan_word* words;
+    plan_piece* pieces;   // 按目标字的顺序排列
+    bitcpy_field* longs;  // 直接调用 bitcpy() 的长段
+};
+
+static int field_cmp_src(const void* a, const void* b) {
+    const bitcpy_field* x = (const bitcpy_field*)a;
+    const bitcpy_field* y = (const bitcpy_field*)b;
+    if (x->src_off != y->src_off) return x->src_off < y->src_off ? -1 : 1;
+    if (x->dst_off != y->dst_off) return x->dst_off < y->dst_off ? -1 : 1;
+    return 0;
+}
+
+static int field_cmp_dst(const void* a, const void* b) {
+    const bitcpy_field* x = (const bitcpy_field*)a;
+    const bitcpy_field* y = (const bitcpy_field*)b;
+    if (x->dst_off != y->dst_off) return x->dst_off < y->dst_off ? -1 : 1;
+    return 0;
+}
+
+// 8 字节访问需要记录起点之后 reach 字节；返回访问可能越过缓冲区末尾的记录数
+static size_t plan_tail_records(uint64_t reach, size_t stride) {
+    return reach <= stride ? 0 : (size_t)((reach - stride + stride - 1) / stride);
+}
+
+void bitcpy_plan_free(bitcpy_plan* plan) {
+    if (plan == NULL) return;
+    free(plan->words);
+    free(plan->pieces);
+    free(plan->longs);
+    free(plan);
+}
+
+bitcpy_plan* bitcpy_plan_compile(const bitcpy_field* fields, size_t n,
+                                 size_t src_stride, size_t dst_stride) {
+    if (src_stride == 0 || dst_stride == 0) return NULL;
+    bitcpy_plan* plan = (bitcpy_plan*)calloc(1, sizeof(bitcpy_plan));
+    bitcpy_field* runs = (bitcpy_field*)malloc((n ? n : 1) * sizeof(bitcpy_field));
+    if (plan == NULL || runs == NULL) {
+        free(plan);
+        free(runs);
+        return NULL;
+    }
+    plan->src_stride = src_stride;
+    plan->dst_stride = dst_stride;
+
+    // 按源偏移排序后合并在两种布局中都首尾相接的字段
+    size_t nruns = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (fields[i].len != 0) runs[nruns++] = fields[i];
+    }
+    qsort(runs, nruns, sizeof(bitcpy_field), field_cmp_src);
+    size_t m = 0;
+    for (size_t i = 0; i < nruns; i++) {
+        if (m > 0 && runs[m - 1].src_off + runs[m - 1].len == runs[i].src_off &&
+            runs[m - 1].dst_off + runs[m - 1].len == runs[i].dst_off) {
+            runs[m - 1].len += runs[i].len;
+        } else {
+            runs[m++] = runs[i];
+        }
+    }
+
+    // 短段在 57 位和目标字边界处切片；每段的片数不超过 len/57 + len/64 + 2
+    size_t max_pieces = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (runs[i].len < PLAN_BITCPY_MIN_BITS) {
+            max_pieces += (size_t)(runs[i].len / PLAN_PIECE_BITS + runs[i].len / 64 + 2);
+        } else {
+            plan->nlong++;
+        }
+    }
+    size_t alloc = max_pieces ? max_pieces : 1;
+    bitcpy_field* cuts = (bitcpy_field*)malloc(alloc * sizeof(bitcpy_field));
+    plan->longs = (bitcpy_field*)malloc((plan->nlong ? plan->nlong : 1) * sizeof(bitcpy_field));
+    plan->pieces = (plan_piece*)malloc(alloc * sizeof(plan_piece));
+    plan->words = (plan_word*)malloc(alloc * sizeof(plan_word));
+    if (cuts == NULL || plan->longs == NULL || plan->pieces == NULL || plan->words == NULL) {
+        free(runs);
+        free(cuts);
+        bitcpy_plan_free(plan);
+        return NULL;
+    }
+    size_t ncuts = 0, nlong = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (runs[i].len >= PLAN_BITCPY_MIN_BITS) {
+            plan->longs[nlong++] = runs[i];
+            continue;
+        }
+        bitcpy_field f = runs[i];
+        while (f.len > 0) {
+            uint64_t piece = 64 - (f.dst_off & 63);
+            if (piece > PLAN_PIECE_BITS) piece = PLAN_PIECE_BITS;
+            if (piece > f.len) piece = f.len;
+            cuts[ncuts].src_off = f.src_off;
+            cuts[ncuts].dst_off = f.dst_off;
+            cuts[ncuts].len = piece;
+            ncuts++;
+            f.src_off += piece;
+            f.dst_off += piece;
+            f.len -= piece;
+        }
+    }
+
+    // 按目标位置排序，同一目标字的片相邻，分组生成字表
+    qsort(cuts, ncuts, sizeof(bitcpy_field), field_cmp_dst);
+    uint64_t src_reach = 0, dst_reach = 0;
+    for (size_t i = 0; i < ncuts; i++) {
+        plan_piece* p = &plan->pieces[i];
+        uint64_t dst_byte = (cuts[i].dst_off >> 6) * 8;
+        p->src_byte = cuts[i].src_off >> 3;
+        p->src_shift = (uint8_t)(cuts[i].src_off & 7);
+        p->dst_shift = (uint8_t)(cuts[i].dst_off & 63);
+        p->len = (uint8_t)cuts[i].len;
+        p->mask = ((uint64_t)1 << p->len) - 1;
+        if (plan->nwords == 0 || plan->words[plan->nwords - 1].dst_byte != dst_byte) {
+            plan_word* w = &plan->words[plan->nwords++];
+            w->dst_byte = dst_byte;
+            w->mask = 0;
+            w->npieces = 0;
+        }
+        plan_word* w = &plan->words[plan->nwords - 1];
+        w->mask |= p->mask << p->dst_shift;
+        w->npieces++;
+        if (p->src_byte + 8 > src_reach) src_reach = p->src_byte + 8;
+    }
+    // 越过记录末尾的字收缩到 mask 覆盖的字节，使每条记录只写自己步长内的字节
+    for (size_t i = 0; i < plan->nwords; i++) {
+        plan_word* w = &plan->words[i];
+        w->nbytes = 8;
+        if (w->dst_byte + 8 > dst_stride) {
+            w->nbytes = (63u - (unsigned)__builtin_clzll(w->mask)) / 8 + 1;
+        }
+        if (w->dst_byte + w->nbytes > dst_reach) dst_reach = w->dst_byte + w->nbytes;
+    }
+    size_t src_tail = plan_tail_records(src_reach, src_stride);
+    size_t dst_tail = plan_tail_records(dst_reach, dst_stride);
+    plan->tail_records = src_tail > dst_tail ? src_tail : dst_tail;
+    free(runs);
+    free(cuts);
+    return plan;
+}
+
+void bitcpy_plan_apply(const bitcpy_plan* plan, uint8_t* dst, const uint8_t* src, size_t nrecords) {
+    size_t fast = nrecords > plan->tail_records ? nrecords - plan->tail_records : 0;
+    const plan_word* words_end = plan->words + plan->nwords;
+    const uint8_t* s = src;
+    uint8_t* d = dst;
+    for (size_t r = 0; r < nrecords; r++) {
+        const plan_piece* p = plan->pieces;
+        if (r < fast) {
+            // 每个目标字：各片从源记录读取、移位后在寄存器中拼接，最后一次读-改-写
+            for (const plan_word* w = plan->words; w < words_end; w++) {
+                uint64_t acc = 0;
+                for (const plan_piece* end = p + w->npieces; p < end; p++) {
+                    uint64_t sv;
+                    memcpy(&sv, s + p->src_byte, 8);
+                    acc |= ((sv >> p->src_shift) & p->mask) << p->dst_shift;
+                }
+                uint64_t dv = 0;
+                if (w->nbytes == 8) {
+                    memcpy(&dv, d + w->dst_byte, 8);
+                    dv = (dv & ~w->mask) | acc;
+                    memcpy(d + w->dst_byte, &dv, 8);
+                } else {
+                    memcpy(&dv, d + w->dst_byte, w->nbytes);
+                    dv = (dv & ~w->mask) | acc;
+                    memcpy(d + w->dst_byte, &dv, w->nbytes);
+                }
+            }
+        } else {
+            for (const plan_word* w = plan->words; w < words_end; w++) {
+                for (const plan_piece* end = p + w->npieces; p < end; p++) {
+                    bitcpy(d + w->dst_byte + (p->dst_shift >> 3), p->dst_shift & 7,
+                           s + p->src_byte, p->src_shift, p->len);
+                }
+            }
+        }
+        for (size_t i = 0; i < plan->nlong; i++) {
+            const bitcpy_field* f = &plan->longs[i];
+            bitcpy(d + (f->dst_off >> 3), f->dst_off & 7, s + (f->src_off >> 3), f->src_off & 7, f->len);
+        }
+        s += plan->src_stride;
+        d += plan->dst_stride;
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * === 整数数组的位打包/解包 ===
+ * 把 n 个整数的低 width 位依次紧凑存放到从 dest 第 dest_bit 位开始的位区间
+ * （第 i 个值占 [dest_bit + i*width, dest_bit + (i+1)*width)），位序与 bitcpy() 相同；解包是其逆操作。
+ * 结果等价于对每个元素调用一次 bitcpy()，但没有逐元素的函数调用。
+ *
+ * === 参数要求（调用者保证） ===
+ * - 32 位版本 width 在 [1, 32] 内，64 位版本 width 在 [1, 64] 内
+ * - dest_bit / src_bit 在 [0, 7] 内
+ * - 位缓冲区至少需要 (bit + n * width + 7) / 8 字节，只访问这些字节
+ * - 打包时区间之外的位保持不变，值中高于 width 的位被忽略
+ *
+ * === 底层优化策略 ===
+ * 8 个值正好占 width 字节，所以每组 8 个值的起始位偏移相同，组内每个值的字节偏移和移位量
+ * 只由 (width, 起始位) 决定。每次调用先按 width 计算这张表（即各宽度的专用重排/移位常量），
+ * 主循环中全部是循环不变量：
+ * - AVX-512 VBMI：VPERMB 把每个值所在的字节重排到各自的 64 位通道，VPSRLVQ/VPSLLVQ 移位；
+ *   解包用掩码读取恰好一组的字节，打包按字节把各通道 OR 合并后掩码写入，组间的共享字节用进位传递
+ * - AVX2（仅解包）：两次 128 位读取 + VPSHUFB 重排 + VPSRLVQ 移位
+ * - 标量：64 位累加器（bitstream 读写游标），处理不足一组的尾部以及不支持的指令集/宽度
+ * SIMD 内核处理 width <= 56 的情况（每个值加上移位量放得进一个 64 位通道），
+ * 在首次调用时通过 CPUID 选定一次；n 较小时直接走标量路径。
+ */
+
+void bitpack32(uint8_t* dest, uint8_t dest_bit, const uint32_t* values, size_t n, unsigned width);
+void bitunpack32(uint32_t* values, const uint8_t* src, uint8_t src_bit, size_t n, unsigned width);
+void bitpack64(uint8_t* dest, uint8_t dest_bit, const uint64_t* values, size_t n, unsigned width);
+void bitunpack64(uint64_t* values, const uint8_t* src, uint8_t src_bit, size_t n, unsigned width);
+
+/*
+ * === 位与字节数组的展开/压缩 ===
+ * 紧凑位区间与每字节一位的数组之间的转换，供按字节向量化的计算使用。
+ *
+ * - bits_to_bytes()：把 src 第 src_bit 位起的 len 位展开为 len 个字节，每个字节为 0 或 1
+ * - bytes_to_bits()：把 len 个字节压缩为从 dest 第 dest_bit 位开始的 len 位，非 0 字节写 1，
+ *   区间之外的位保持不变
+ *
+ * src_bit / dest_bit 在 [0, 7] 内；位缓冲区只访问 (bit + len + 7) / 8 字节，字节数组只访问 len 字节；
+ * 位缓冲区和字节数组不能重叠。
+ *
+ * === 底层优化策略 ===
+ * 先处理位区间起点所在的不完整字节，之后每个位字节对应 8 个数组字节：
+ * - AVX-512BW：展开时 8 个位字节直接作为写掩码（零掩码的 VMOVDQU8），压缩用 VPTESTMB，每步 64 位
+ * - AVX2：展开用 VPSHUFB 复制位字节再与位选择掩码比较，每步 32 位；压缩用 VPCMPEQB + VPMOVMSKB，每步 64 位
+ * - BMI2：每个位字节一次 PDEP / PEXT
+ * - 标量：移位掩码散布和乘法收集，每次处理 8 位
+ * 内核在首次调用时通过 CPUID 选定一次。
+ */
+
+void bits_to_bytes(uint8_t* bytes, const uint8_t* src, uint8_t src_bit, uint64_t len);
+void bytes_to_bits(uint8_t* dest, uint8_t dest_bit, const uint8_t* bytes, uint64_t len);
+
+/*
+ * === 记录布局转换计划 ===
+ * 两种紧凑记录布局之间的转换：每条记录把同一组字段从源布局拷贝到目标布局。
+ * 字段列表预先编译成计划，之后对任意多条记录重复执行，结果等价于对每条记录的每个字段调用一次 bitcpy()：
+ *   bitcpy(dst + r * dst_stride + dst_off / 8, dst_off % 8, src + r * src_stride + src_off / 8, src_off % 8, len)
+ * 目标记录中不属于任何字段的位保持不变。
+ *
+ * === 参数要求（调用者保证） ===
+ * - 记录步长以字节为单位且不为 0，字段偏移是相对记录起点的位偏移，字段可以跨越记录的字节边界
+ * - 同一计划中各字段的目标区间互不重叠；源缓冲区和目标缓冲区不能重叠
+ * - 源缓冲区可读 nrecords * src_stride 字节，目标缓冲区可写 nrecords * dst_stride 字节
+ *
+ * === 底层优化策略 ===
+ * 编译时：
+ * - 按源偏移排序，在两种布局中都首尾相接的字段合并为一段
+ * - 短于 256 位的段在目标 64 位字边界处和每 57 位处切片，各片按目标字分组，
+ *   预先算好源字节下标、移位量、掩码以及每个目标字的下标和覆盖掩码
+ * - 不少于 256 位的段在执行时直接调用 bitcpy()
+ * 执行时每个目标字的各片各做一次 8 字节非对齐读取和移位掩码，在寄存器中拼接后对目标字读-改-写一次，
+ * 没有按字段的分支和函数调用，也不会因为相邻字段的读写重叠而让读取等待前一次写入。
+ * 越过记录末尾的目标字只读写到其中最高的字段字节，每条记录只写自己步长内的字节。
+ * 8 字节读取会越过记录中最后一个字段，可能超出最后几条记录；编译时算出这样的记录数，
+ * 执行到这些记录时改为逐片调用 bitcpy()，不会访问缓冲区之外的字节。
+ */
+
+typedef struct {
+    uint64_t src_off;  // 字段在源记录中的起始位
+    uint64_t dst_off;  // 字段在目标记录中的起始位
+    uint64_t len;      // 字段位数，0 的字段被忽略
+} bitcpy_field;
+
+typedef struct bitcpy_plan bitcpy_plan;
+
+/**
+ * @brief 编译字段列表
+ * @param fields      字段数组，编译后不再引用
+ * @param n           字段个数
+ * @param src_stride  源记录步长（字节）
+ * @param dst_stride  目标记录步长（字节）
+ * @return 计划，用 bitcpy_plan_free() 释放；步长为 0 或内存不足时返回 NULL
+ */
+bitcpy_plan* bitcpy_plan_compile(const bitcpy_field* fields, size_t n,
+                                 size_t src_stride, size_t dst_stride);
+
+/**
+ * @brief 对 nrecords 条连续记录执行计划
+ *
+ * 计划编译后只读，可以在多个线程中同时执行。每条记录只读-改-写自己步长内的字节，
+ * 所以可以把一个目标缓冲区按记录区间分给多个线程，区间之间不需要间隔。
+ */
+void bitcpy_plan_apply(const bitcpy_plan* plan, uint8_t* dst, const uint8_t* src, size_t nrecords);
+
+void bitcpy_plan_free(bitcpy_plan* plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITPACK_H
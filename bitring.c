@@ -0,0 +1,55 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitring.h"
+
+void bitring_init(bitring* r, uint8_t* buf, size_t bytes) {
+    memset(r, 0, sizeof(*r));
+    r->buf = buf;
+    r->cap = (uint64_t)bytes * 8;
+}
+
+int bitring_push(bitring* r, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return 1;  // 不访问缓冲区，容量为 0 时也不取模
+    uint64_t head = r->head;
+    if (r->cap - (head - r->tail_cache) < len) {
+        // 缓存的 tail 显示空间不足时才读取消费者的最新进度
+        r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (r->cap - (head - r->tail_cache) < len) return 0;
+    }
+
+    uint64_t pos = head % r->cap;
+    uint64_t first = r->cap - pos;
+    if (first > len) first = len;
+    bitcpy(r->buf + (pos >> 3), (uint8_t)(pos & 7), src, src_bit, first);
+    if (first < len) {
+        // 回绕到缓冲区开头
+        uint64_t s = src_bit + first;
+        bitcpy(r->buf, 0, src + (s >> 3), (uint8_t)(s & 7), len - first);
+    }
+    __atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int bitring_pop(bitring* r, uint8_t* dest, uint8_t dest_bit, uint64_t len) {
+    if (len == 0) return 1;
+    uint64_t tail = r->tail;
+    if (r->head_cache - tail < len) {
+        r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (r->head_cache - tail < len) return 0;
+    }
+
+    uint64_t pos = tail % r->cap;
+    uint64_t first = r->cap - pos;
+    if (first > len) first = len;
+    bitcpy(dest, dest_bit, r->buf + (pos >> 3), (uint8_t)(pos & 7), first);
+    if (first < len) {
+        uint64_t d = dest_bit + first;
+        bitcpy(dest + (d >> 3), (uint8_t)(d & 7), r->buf, 0, len - first);
+    }
+    __atomic_store_n(&r->tail, tail + len, __ATOMIC_RELEASE);
+    return 1;
+}
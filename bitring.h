@@ -0,0 +1,78 @@
+#ifndef BITRING_H
+#define BITRING_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * === 单生产者/单消费者位环形缓冲区 ===
+ * 以位为单位寻址的 FIFO：一个线程写入任意位数的记录，另一个线程按写入顺序读出，
+ * 记录不需要补齐到字节，缓冲区的每一位都可以使用。位序与 bitcpy() 相同。
+ *
+ * === 实现 ===
+ * - head/tail 是单调递增的已写入/已读出总位数，在缓冲区中的位置为对容量取模；
+ *   生产者以 release 语义发布 head，消费者以 release 语义发布 tail，对方以 acquire 读取，
+ *   因此记录的数据在 head 可见时一定已经写完，缓冲区的位在 tail 越过之前不会被覆盖
+ * - 每一侧缓存最近读到的对方索引，空间或数据足够时不访问对方的缓存行；
+ *   两侧的索引分别位于独立的 64 字节缓存行
+ * - 写入和读出各自最多分成两段（在缓冲区末尾回绕），每段调用一次 bitcpy()
+ *
+ * 写入首尾不完整的字节时，bitcpy() 会读-改-写该字节中不属于本次记录的位（原值写回），
+ * 其中可能有消费者正在读取的位；这些位的值不会改变，因此不影响消费者读到的数据。
+ */
+
+typedef struct {
+    uint8_t* buf;
+    uint64_t cap;           // 容量（位）= 缓冲区字节数 * 8
+    uint8_t pad0[48];
+    uint64_t head;          // 已写入的总位数，只由生产者写入
+    uint64_t tail_cache;    // 生产者最近读到的 tail
+    uint8_t pad1[48];
+    uint64_t tail;          // 已读出的总位数，只由消费者写入
+    uint64_t head_cache;    // 消费者最近读到的 head
+    uint8_t pad2[48];
+} bitring;
+
+/**
+ * @brief 初始化为空的环形缓冲区
+ * @param buf    缓冲区，由调用者分配，生命周期覆盖环形缓冲区的使用
+ * @param bytes  缓冲区字节数，容量为 bytes * 8 位；为 0 时 len > 0 的写入和读出都返回 0
+ *
+ * 初始化之后、生产者和消费者线程开始使用之前需要有同步（例如创建线程）。
+ */
+void bitring_init(bitring* r, uint8_t* buf, size_t bytes);
+
+/**
+ * @brief 生产者：把 src 第 src_bit 位（0-7）起的 len 位追加到环形缓冲区
+ * @return 1 成功（len == 0 时立即返回 1）；0 空闲空间不足 len 位，不写入任何位
+ */
+int bitring_push(bitring* r, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 消费者：读出最早写入的 len 位，写到 dest 第 dest_bit 位（0-7）起，区间之外的位保持不变
+ * @return 1 成功（len == 0 时立即返回 1）；0 缓冲区中不足 len 位，不读出任何位
+ */
+int bitring_pop(bitring* r, uint8_t* dest, uint8_t dest_bit, uint64_t len);
+
+/**
+ * @brief 消费者：当前可读的位数
+ */
+static inline uint64_t bitring_readable(bitring* r) {
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - r->tail;
+}
+
+/**
+ * @brief 生产者：当前可写的位数
+ */
+static inline uint64_t bitring_writable(bitring* r) {
+    return r->cap - (r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITRING_H
@@ -0,0 +1,461 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitscan.h"
+#include "bitcpy_simd.h"
+
+// 少于该字节数时直接走标量循环，避免间接调用的开销
+#define SCAN_SIMD_MIN_BYTES 64
+
+// 读取从 p 第 bit 位开始的 n 位（1-8），源数据可能跨两个字节
+static inline uint8_t load_bits8(const uint8_t* p, unsigned bit, unsigned n) {
+    uint16_t v = p[0];
+    if (bit + n > 8) {
+        v |= (uint16_t)p[1] << 8;
+    }
+    return (uint8_t)(v >> bit);
+}
+
+// 读取从 p 第 bit 位开始的 64 位；bit != 0 时读取 9 字节
+static inline uint64_t load_bits64(const uint8_t* p, unsigned bit) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    if (bit != 0) {
+        v = (v >> bit) | ((uint64_t)p[8] << (64 - bit));
+    }
+    return v;
+}
+
+static inline unsigned popcount64(uint64_t v) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// v != 0
+static inline unsigned ctz64(uint64_t v) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(v);
+#else
+    unsigned n = 0;
+    while ((v & 1) == 0) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/*
+ * === 计数内核 ===
+ * 统计 p[0..n) 中整向量部分的 1 的个数累加到 *count，返回已处理的字节数，剩余部分交给标量循环。
+ */
+#ifdef BITCPY_X86_SIMD
+typedef size_t (*count_kernel_fn)(const uint8_t* p, size_t n, uint64_t* count);
+
+// 编译时未启用 POPCNT 指令时，__builtin_popcountll 会变成查表函数调用；单独编译一个使用该指令的循环
+__attribute__((target("popcnt")))
+static size_t count_kernel_popcnt(const uint8_t* p, size_t n, uint64_t* count) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        uint64_t w[4];
+        memcpy(w, p + i, 32);
+        c0 += (uint64_t)__builtin_popcountll(w[0]);
+        c1 += (uint64_t)__builtin_popcountll(w[1]);
+        c2 += (uint64_t)__builtin_popcountll(w[2]);
+        c3 += (uint64_t)__builtin_popcountll(w[3]);
+    }
+    *count += c0 + c1 + c2 + c3;
+    return i;
+}
+
+// 每字节的 1 的个数：高低半字节分别 VPSHUFB 查表，VPSADBW 横向求和到 4 个 64 位通道
+__attribute__((target("avx2")))
+static inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low4));
+    __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+// 进位保留加法器：三个输入的每一位相加，h 为进位、l 为本位
+__attribute__((target("avx2")))
+static inline void csa256(__m256i* h, __m256i* l, __m256i a, __m256i b, __m256i c) {
+    __m256i u = _mm256_xor_si256(a, b);
+    *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    *l = _mm256_xor_si256(u, c);
+}
+
+// Harley-Seal：每 16 个向量经过进位保留加法器树，只对权重为 16 的结果做一次真正的 popcount
+__attribute__((target("avx2")))
+static size_t count_kernel_avx2(const uint8_t* p, size_t n, uint64_t* count) {
+    const __m256i* v = (const __m256i*)p;
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256(), twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256(), eights = _mm256_setzero_si256();
+    __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+    size_t blocks = n / 32;
+    size_t i = 0;
+    for (; i + 16 <= blocks; i += 16) {
+        csa256(&twos_a, &ones, ones, _mm256_loadu_si256(v + i), _mm256_loadu_si256(v + i + 1));
+        csa256(&twos_b, &ones, ones, _mm256_loadu_si256(v + i + 2), _mm256_loadu_si256(v + i + 3));
+        csa256(&fours_a, &twos, twos, twos_a, twos_b);
+        csa256(&twos_a, &ones, ones, _mm256_loadu_si256(v + i + 4), _mm256_loadu_si256(v + i + 5));
+        csa256(&twos_b, &ones, ones, _mm256_loadu_si256(v + i + 6), _mm256_loadu_si256(v + i + 7));
+        csa256(&fours_b, &twos, twos, twos_a, twos_b);
+        csa256(&eights_a, &fours, fours, fours_a, fours_b);
+        csa256(&twos_a, &ones, ones, _mm256_loadu_si256(v + i + 8), _mm256_loadu_si256(v + i + 9));
+        csa256(&twos_b, &ones, ones, _mm256_loadu_si256(v + i + 10), _mm256_loadu_si256(v + i + 11));
+        csa256(&fours_a, &twos, twos, twos_a, twos_b);
+        csa256(&twos_a, &ones, ones, _mm256_loadu_si256(v + i + 12), _mm256_loadu_si256(v + i + 13));
+        csa256(&twos_b, &ones, ones, _mm256_loadu_si256(v + i + 14), _mm256_loadu_si256(v + i + 15));
+        csa256(&fours_b, &twos, twos, twos_a, twos_b);
+        csa256(&eights_b, &fours, fours, fours_a, fours_b);
+        csa256(&sixteens, &eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount256(sixteens));
+    }
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+    total = _mm256_add_epi64(total, popcount256(ones));
+    for (; i < blocks; i++) {
+        total = _mm256_add_epi64(total, popcount256(_mm256_loadu_si256(v + i)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    *count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    return blocks * 32;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t count_kernel_avx512(const uint8_t* p, size_t n, uint64_t* count) {
+    __m512i c0 = _mm512_setzero_si512(), c1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        c0 = _mm512_add_epi64(c0, _mm512_popcnt_epi64(_mm512_loadu_si512((const void*)(p + i))));
+        c1 = _mm512_add_epi64(c1, _mm512_popcnt_epi64(_mm512_loadu_si512((const void*)(p + i + 64))));
+    }
+    for (; i + 64 <= n; i += 64) {
+        c0 = _mm512_add_epi64(c0, _mm512_popcnt_epi64(_mm512_loadu_si512((const void*)(p + i))));
+    }
+    *count += (uint64_t)_mm512_reduce_add_epi64(_mm512_add_epi64(c0, c1));
+    return i;
+}
+
+static size_t count_kernel_none(const uint8_t* p, size_t n, uint64_t* count) {
+    (void)p; (void)n; (void)count;
+    return 0;
+}
+
+static size_t count_kernel_resolve(const uint8_t* p, size_t n, uint64_t* count);
+static count_kernel_fn count_kernel = count_kernel_resolve;
+
+// 首次调用时选择内核；多线程同时初始化只会写入相同的值
+static size_t count_kernel_resolve(const uint8_t* p, size_t n, uint64_t* count) {
+    count_kernel_fn fn = count_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) {
+        fn = count_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = count_kernel_avx2;
+    } else if (__builtin_cpu_supports("popcnt")) {
+        fn = count_kernel_popcnt;
+    }
+    count_kernel = fn;
+    return fn(p, n, count);
+}
+
+/*
+ * === 查找内核 ===
+ * 从 p 开始按整向量跳过与 flip 逐位相同的数据（flip 为 0 时跳过全 0，为全 1 时跳过全 1），
+ * 返回第一个含有目标位的向量的起点，或者已跳过的整向量字节数；确切位置由调用者的 64 位字循环确定。
+ */
+typedef size_t (*find_kernel_fn)(const uint8_t* p, size_t n, uint64_t flip);
+
+__attribute__((target("sse2")))
+static size_t find_kernel_sse2(const uint8_t* p, size_t n, uint64_t flip) {
+    const __m128i f = _mm_set1_epi64x((long long)flip);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + i)), f);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF) break;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t find_kernel_avx2(const uint8_t* p, size_t n, uint64_t flip) {
+    const __m256i f = _mm256_set1_epi64x((long long)flip);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + i)), f);
+        __m256i v1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + i + 32)), f);
+        if (!_mm256_testz_si256(_mm256_or_si256(v0, v1), _mm256_or_si256(v0, v1))) break;
+    }
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + i)), f);
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    return i;
+}
+
+static size_t find_kernel_none(const uint8_t* p, size_t n, uint64_t flip) {
+    (void)p; (void)n; (void)flip;
+    return 0;
+}
+
+static size_t find_kernel_resolve(const uint8_t* p, size_t n, uint64_t flip);
+static find_kernel_fn find_kernel = find_kernel_resolve;
+
+static size_t find_kernel_resolve(const uint8_t* p, size_t n, uint64_t flip) {
+    find_kernel_fn fn = find_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        fn = find_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = find_kernel_sse2;
+    }
+    find_kernel = fn;
+    return fn(p, n, flip);
+}
+
+/*
+ * === 比较内核 ===
+ * a 已字节对齐，b 按 sb 位移位拼接（bitcpy_funnel_load*()，每个向量多读 1 字节，调用者据此限制 n）。
+ * 返回第一个不同的向量的起点，或者已比较的整向量字节数。
+ */
+typedef size_t (*cmp_kernel_fn)(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n);
+
+__attribute__((target("sse2")))
+static size_t cmp_kernel_sse2(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)sb);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - sb));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = bitcpy_funnel_load128(b + i, rs, ls);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) break;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t cmp_kernel_avx2(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)sb);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - sb));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                      bitcpy_funnel_load256(b + i, rs, ls));
+        __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 32)),
+                                      bitcpy_funnel_load256(b + i + 32, rs, ls));
+        __m256i d = _mm256_or_si256(d0, d1);
+        if (!_mm256_testz_si256(d, d)) break;
+    }
+    for (; i + 32 <= n; i += 32) {
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                     bitcpy_funnel_load256(b + i, rs, ls));
+        if (!_mm256_testz_si256(d, d)) break;
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t cmp_kernel_avx512(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n) {
+    const __m128i rs = _mm_cvtsi32_si128((int)sb);
+    const __m128i ls = _mm_cvtsi32_si128((int)(8 - sb));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i x = _mm512_loadu_si512((const void*)(a + i));
+        if (_mm512_cmpneq_epi64_mask(x, bitcpy_funnel_load512(b + i, rs, ls)) != 0) break;
+    }
+    return i;
+}
+
+static size_t cmp_kernel_none(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n) {
+    (void)a; (void)b; (void)sb; (void)n;
+    return 0;
+}
+
+static size_t cmp_kernel_resolve(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n);
+static cmp_kernel_fn cmp_kernel = cmp_kernel_resolve;
+
+static size_t cmp_kernel_resolve(const uint8_t* a, const uint8_t* b, unsigned sb, size_t n) {
+    cmp_kernel_fn fn = cmp_kernel_none;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        fn = cmp_kernel_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        fn = cmp_kernel_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = cmp_kernel_sse2;
+    }
+    cmp_kernel = fn;
+    return fn(a, b, sb, n);
+}
+#endif
+
+uint64_t bitcount(const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return 0;
+    uint64_t count = 0;
+    
+    // 首字节：src_bit 之后的 1-8 位
+    if (src_bit != 0) {
+        unsigned n = 8 - src_bit;
+        if (n > len) n = (unsigned)len;
+        count += popcount64((uint64_t)(src[0] >> src_bit) & ((1u << n) - 1));
+        len -= n;
+        src++;
+    }
+    
+    // 中间整字节
+    size_t bytes = (size_t)(len >> 3);
+    size_t i = 0;
+#ifdef BITCPY_X86_SIMD
+    if (bytes >= SCAN_SIMD_MIN_BYTES) {
+        i = count_kernel(src, bytes, &count);
+    }
+#endif
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, src + i, 8);
+        count += popcount64(w);
+    }
+    for (; i < bytes; i++) {
+        count += popcount64(src[i]);
+    }
+    
+    // 末字节：剩余 1-7 位
+    if ((len & 7) != 0) {
+        count += popcount64(src[bytes] & ((1u << (len & 7)) - 1));
+    }
+    return count;
+}
+
+// flip 为 0 时查找 1，为全 1 时查找 0：每个字先与 flip 异或，再查找第一个 1
+static uint64_t bitfind(const uint8_t* src, uint8_t src_bit, uint64_t len, uint64_t flip) {
+    if (len == 0) return 0;
+    uint64_t base = 0;  // src 当前字节第 0 位对应的区间序号
+    
+    // 首字节：src_bit 之后的 1-8 位
+    if (src_bit != 0) {
+        unsigned n = 8 - src_bit;
+        if (n > len) n = (unsigned)len;
+        uint64_t v = ((uint64_t)((src[0] ^ (uint8_t)flip) >> src_bit)) & ((1u << n) - 1);
+        if (v != 0) return ctz64(v);
+        base = n;
+        src++;
+    }
+    
+    uint64_t rest = len - base;
+    size_t bytes = (size_t)(rest >> 3);
+    size_t i = 0;
+#ifdef BITCPY_X86_SIMD
+    if (bytes >= SCAN_SIMD_MIN_BYTES) {
+        i = find_kernel(src, bytes, flip);
+    }
+#endif
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, src + i, 8);
+        w ^= flip;
+        if (w != 0) return base + ((uint64_t)i << 3) + ctz64(w);
+    }
+    for (; i < bytes; i++) {
+        uint64_t v = (uint8_t)(src[i] ^ (uint8_t)flip);
+        if (v != 0) return base + ((uint64_t)i << 3) + ctz64(v);
+    }
+    
+    // 末字节：剩余 1-7 位
+    if ((rest & 7) != 0) {
+        uint64_t v = (uint64_t)((src[bytes] ^ (uint8_t)flip) & ((1u << (rest & 7)) - 1));
+        if (v != 0) return base + ((uint64_t)bytes << 3) + ctz64(v);
+    }
+    return len;
+}
+
+uint64_t bitfind_set(const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    return bitfind(src, src_bit, len, 0);
+}
+
+uint64_t bitfind_clear(const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    return bitfind(src, src_bit, len, ~(uint64_t)0);
+}
+
+// 返回第一个不同位的序号，相同时返回 len
+static uint64_t bitdiff(const uint8_t* a, uint8_t a_bit, const uint8_t* b, uint8_t b_bit, uint64_t len) {
+    uint64_t base = 0;  // a 当前字节第 0 位对应的区间序号
+    
+    // 首部：使 a 对齐到字节边界
+    if (a_bit != 0) {
+        unsigned n = 8 - a_bit;
+        if (n > len) n = (unsigned)len;
+        unsigned d = (unsigned)(load_bits8(a, a_bit, n) ^ load_bits8(b, b_bit, n)) & ((1u << n) - 1);
+        if (d != 0) return ctz64(d);
+        base = n;
+        a++;
+        b += (b_bit + n) >> 3;
+        b_bit = (b_bit + n) & 7;
+    }
+    
+    uint64_t rest = len - base;
+#ifdef BITCPY_X86_SIMD
+    if (rest >= (uint64_t)SCAN_SIMD_MIN_BYTES * 8) {
+        // 内核对 b 多读 1 字节：比较字节数不能超过 b 的可读字节数 - 1
+        size_t n = (size_t)(rest >> 3);
+        size_t b_limit = (size_t)((b_bit + rest + 7) >> 3) - 1;
+        if (n > b_limit) n = b_limit;
+        size_t done = cmp_kernel(a, b, b_bit, n);
+        a += done;
+        b += done;
+        base += (uint64_t)done << 3;
+        rest -= (uint64_t)done << 3;
+    }
+#endif
+    // b 非对齐时需要读取 9 字节，刚好剩 64 位时退回字节处理（与 bitcpy() 相同）
+    while (rest > 64 || (rest == 64 && b_bit == 0)) {
+        uint64_t x;
+        memcpy(&x, a, 8);
+        uint64_t d = x ^ load_bits64(b, b_bit);
+        if (d != 0) return base + ctz64(d);
+        a += 8;
+        b += 8;
+        base += 64;
+        rest -= 64;
+    }
+    while (rest > 0) {
+        unsigned n = rest < 8 ? (unsigned)rest : 8;
+        unsigned d = (unsigned)(a[0] ^ load_bits8(b, b_bit, n)) & ((1u << n) - 1);
+        if (d != 0) return base + ctz64(d);
+        a++;
+        b++;
+        base += n;
+        rest -= n;
+    }
+    return len;
+}
+
+int bitcmp(const uint8_t* a, uint8_t a_bit, const uint8_t* b, uint8_t b_bit,
+           uint64_t len, uint64_t* first_diff) {
+    uint64_t d = len == 0 ? 0 : bitdiff(a, a_bit, b, b_bit, len);
+    if (first_diff) *first_diff = d;
+    if (d == len) return 0;
+    uint64_t pos = a_bit + d;
+    return ((a[pos >> 3] >> (pos & 7)) & 1) ? 1 : -1;
+}
+
+int bitequal(const uint8_t* a, uint8_t a_bit, const uint8_t* b, uint8_t b_bit, uint64_t len) {
+    return len == 0 || bitdiff(a, a_bit, b, b_bit, len) == len;
+}
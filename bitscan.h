@@ -0,0 +1,67 @@
+#ifndef BITSCAN_H
+#define BITSCAN_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * === 位区间计数与查找 ===
+ * 对从 src 第 src_bit 位（0-7）开始的 len 位做只读查询，位序与 bitcpy() 相同。
+ * 各函数只读取 (src_bit + len + 7) / 8 字节；len == 0 时不访问内存。
+ *
+ * === 底层优化策略 ===
+ * 首尾不足一个字节的部分用掩码处理，中间部分按字节对齐后交给向量内核，
+ * 内核在首次调用时通过 CPUID 选定一次，定义 BITCPY_NO_SIMD 时只使用标量循环：
+ * - bitcount：AVX-512 VPOPCNTQ > AVX2（Harley-Seal 进位保留加法器 + VPSHUFB 查表）> POPCNT > 标量
+ * - bitfind_set/bitfind_clear：AVX2/SSE2 按整向量跳过不含目标位的数据，
+ *   命中后由 64 位字扫描和 ctz 确定位置
+ * - bitcmp/bitequal：先使 a 对齐到字节边界，b 与 bitcpy() 阶段2相同地移位拼接；
+ *   AVX-512/AVX2/SSE2 按整向量比较，遇到第一个不同的向量立即退出，再由 64 位字异或和 ctz 确定位置
+ */
+
+/**
+ * @brief 统计区间内值为 1 的位数
+ */
+uint64_t bitcount(const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 查找区间内第一个值为 1 的位
+ * @return 相对区间起点的位序号（0 到 len - 1），没有找到时返回 len
+ */
+uint64_t bitfind_set(const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 查找区间内第一个值为 0 的位
+ * @return 相对区间起点的位序号（0 到 len - 1），没有找到时返回 len
+ */
+uint64_t bitfind_clear(const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+/**
+ * @brief 比较两个起始位偏移各不相同的位区间
+ * @param a          第一个区间（指向起始字节）
+ * @param a_bit      第一个区间的起始位偏移（0-7）
+ * @param b          第二个区间（指向起始字节）
+ * @param b_bit      第二个区间的起始位偏移（0-7）
+ * @param len        位数
+ * @param first_diff 非 NULL 时写入第一个不同位的序号（相对区间起点），相同时写入 len
+ * @return 相同返回 0；否则在第一个不同位上 a 为 0 返回 -1，a 为 1 返回 1
+ *
+ * 顺序按位序号从低到高逐位比较（与 bitcpy() 的位序一致），相当于把区间看作位序列的字典序。
+ * 两个缓冲区分别只读取 (bit + len + 7) / 8 字节。
+ */
+int bitcmp(const uint8_t* a, uint8_t a_bit, const uint8_t* b, uint8_t b_bit,
+           uint64_t len, uint64_t* first_diff);
+
+/**
+ * @brief 两个位区间是否相同，相同返回 1，否则返回 0
+ */
+int bitequal(const uint8_t* a, uint8_t a_bit, const uint8_t* b, uint8_t b_bit, uint64_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITSCAN_H
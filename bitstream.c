@@ -0,0 +1,94 @@
+/*
+#版权所有 (c) HUJI 2024
+#许可证协议:MIT
+Email: Mhuixs.db@outlook.com
+*/
+
+#include "bitstream.h"
+
+// 少于该位数时经过累加器拷贝，否则直接调用 bitcpy()
+#define BITSTREAM_COPY_MIN_BITS 256
+
+void bitstream_writer_init(bitstream_writer* w, uint8_t* buf, uint8_t bit_offset) {
+    w->start = buf;
+    w->ptr = buf;
+    // 起始字节中 bit_offset 以下的位先装入累加器，整字写回时原样写回
+    w->acc = bit_offset ? buf[0] & bitstream_mask(bit_offset) : 0;
+    w->nacc = bit_offset;
+}
+
+void bitstream_writer_flush(bitstream_writer* w) {
+    unsigned full = w->nacc >> 3;
+    unsigned rest = w->nacc & 7;
+    memcpy(w->ptr, &w->acc, full);
+    if (rest != 0) {
+        uint8_t mask = (uint8_t)bitstream_mask(rest);
+        uint8_t bits = (uint8_t)(w->acc >> (full * 8));
+        w->ptr[full] = (uint8_t)((w->ptr[full] & ~mask) | (bits & mask));
+    }
+}
+
+void bitstream_reader_init(bitstream_reader* r, const uint8_t* buf, uint8_t bit_offset, uint64_t len) {
+    r->start = buf;
+    r->ptr = buf;
+    r->end = buf + ((bit_offset + len) >> 3);
+    r->tail_bits = (unsigned)((bit_offset + len) & 7);
+    r->acc = 0;
+    r->nacc = 0;
+    if (bit_offset != 0) {
+        bitstream_get_bits(r, bit_offset);
+    }
+}
+
+uint64_t bitstream_load_tail(bitstream_reader* r, unsigned* got) {
+    uint64_t word = 0;
+    unsigned n = r->ptr < r->end ? (unsigned)(r->end - r->ptr) : 0;  // 0-7
+    for (unsigned i = 0; i < n; i++) {
+        word |= (uint64_t)r->ptr[i] << (8 * i);
+    }
+    r->ptr += n;
+    *got = n * 8;
+    // 不完整的末字节：范围之外的高位装入为 0
+    if (r->tail_bits != 0 && r->ptr == r->end) {
+        word |= (uint64_t)(r->ptr[0] & bitstream_mask(r->tail_bits)) << (8 * n);
+        r->ptr++;
+        *got += 8;
+    }
+    return word;
+}
+
+void bitstream_copy_bits(bitstream_writer* w, bitstream_reader* r, uint64_t n) {
+    if (n < BITSTREAM_COPY_MIN_BITS) {
+        while (n >= 64) {
+            bitstream_put_bits(w, bitstream_get_bits(r, 64), 64);
+            n -= 64;
+        }
+        bitstream_put_bits(w, bitstream_get_bits(r, (unsigned)n), (unsigned)n);
+        return;
+    }
+
+    // 读游标当前位置：累加器中的位尚未消费，回退到它们所在的字节
+    const uint8_t* src = r->ptr - ((r->nacc + 7) >> 3);
+    uint8_t src_bit = (uint8_t)((8 - (r->nacc & 7)) & 7);
+    // 写游标当前位置：先写回累加器（包括当前字节中已写入的低位）
+    bitstream_writer_flush(w);
+    uint8_t* dest = w->ptr + (w->nacc >> 3);
+    uint8_t dest_bit = (uint8_t)(w->nacc & 7);
+
+    bitcpy(dest, dest_bit, src, src_bit, n);
+
+    // 移动读游标：从新位置所在字节重新装入
+    uint64_t src_pos = src_bit + n;
+    r->ptr = src + (src_pos >> 3);
+    r->acc = 0;
+    r->nacc = 0;
+    if ((src_pos & 7) != 0) {
+        bitstream_get_bits(r, (unsigned)(src_pos & 7));
+    }
+
+    // 移动写游标：新位置所在字节中已写入的低位重新装入累加器
+    uint64_t dest_pos = dest_bit + n;
+    w->ptr = dest + (dest_pos >> 3);
+    w->nacc = (unsigned)(dest_pos & 7);
+    w->acc = w->nacc ? w->ptr[0] & bitstream_mask(w->nacc) : 0;
+}
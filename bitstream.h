@@ -0,0 +1,136 @@
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include "bitcpy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * === 位流读写游标 ===
+ * 在紧凑位缓冲区上顺序写入/读取可变宽度字段，位序与 bitcpy() 相同（LSB 优先）。
+ * 读写都经过一个 64 位累加器：写入攒满 64 位才整字写回，读取一次装入 8 字节，
+ * 每个字段只做几次移位和掩码，不需要函数调用和部分字节的读-改-写。
+ * 大段数据由 bitstream_copy_bits() 直接交给 bitcpy()。
+ *
+ * 与 bitcpy() 一样假定主机是小端序，且不做越界检查：调用者保证缓冲区足够大。
+ */
+
+typedef struct {
+    uint8_t* start;  // 初始化时的缓冲区起点（位置 0 为其最低位）
+    uint8_t* ptr;    // 累加器第 0 位对应的字节，攒满 64 位后整字写到这里
+    uint64_t acc;    // 未写回的位，低位在前
+    unsigned nacc;   // 累加器中的位数（0-63）
+} bitstream_writer;
+
+typedef struct {
+    const uint8_t* start;  // 初始化时的缓冲区起点
+    const uint8_t* ptr;    // 下一个要装入累加器的字节
+    const uint8_t* end;    // 可读范围中完整字节的结束（不含），整字装入时不会越过
+    uint64_t acc;          // 已装入但未读出的位，低位在前
+    unsigned nacc;         // 累加器中的位数（0-64）
+    unsigned tail_bits;    // end 所指字节中属于可读范围的低位数（0-7）
+} bitstream_reader;
+
+static inline uint64_t bitstream_mask(unsigned n) {
+    return n >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+}
+
+/**
+ * @brief 初始化写游标，从 buf 的第 bit_offset 位（0-7）开始写；该字节中更低的位保持不变
+ */
+void bitstream_writer_init(bitstream_writer* w, uint8_t* buf, uint8_t bit_offset);
+
+/**
+ * @brief 把累加器中未写回的位写入缓冲区，不改变游标状态，可以继续写入
+ *
+ * 只写到当前位置所在的字节，该字节中当前位置之后的位保持不变。
+ * 读取输出之前必须调用一次。
+ */
+void bitstream_writer_flush(bitstream_writer* w);
+
+/**
+ * @brief 当前写位置（相对 buf 第 0 位，包含初始化时的 bit_offset）
+ */
+static inline uint64_t bitstream_writer_tell(const bitstream_writer* w) {
+    return (uint64_t)(w->ptr - w->start) * 8 + w->nacc;
+}
+
+/**
+ * @brief 写入 v 的低 n 位（n 为 0-64），v 的高位被忽略
+ */
+static inline void bitstream_put_bits(bitstream_writer* w, uint64_t v, unsigned n) {
+    v &= bitstream_mask(n);
+    w->acc |= v << w->nacc;
+    unsigned total = w->nacc + n;
+    if (total < 64) {
+        w->nacc = total;
+        return;
+    }
+    // 攒满 64 位：整字写回，溢出的高位留在累加器
+    memcpy(w->ptr, &w->acc, 8);
+    w->ptr += 8;
+    w->acc = w->nacc ? v >> (64 - w->nacc) : 0;
+    w->nacc = total - 64;
+}
+
+/**
+ * @brief 初始化读游标，可读范围为 buf 第 bit_offset 位（0-7）起的 len 位
+ *
+ * 装入累加器时不会读取范围之外的字节；读出超过 len 的位返回 0。
+ */
+void bitstream_reader_init(bitstream_reader* r, const uint8_t* buf, uint8_t bit_offset, uint64_t len);
+
+/**
+ * @brief 当前读位置（相对 buf 第 0 位，包含初始化时的 bit_offset）
+ */
+static inline uint64_t bitstream_reader_tell(const bitstream_reader* r) {
+    return (uint64_t)(r->ptr - r->start) * 8 - r->nacc;
+}
+
+// 慢路径：可读范围末尾不足 8 个完整字节时逐字节装入，最后不完整的字节只装入范围内的位
+uint64_t bitstream_load_tail(bitstream_reader* r, unsigned* got);
+
+/**
+ * @brief 读出 n 位（n 为 0-64），返回值的低 n 位有效
+ */
+static inline uint64_t bitstream_get_bits(bitstream_reader* r, unsigned n) {
+    uint64_t v;
+    if (n <= r->nacc) {
+        v = r->acc & bitstream_mask(n);
+        r->acc = n < 64 ? r->acc >> n : 0;
+        r->nacc -= n;
+        return v;
+    }
+
+    // 累加器不够：装入下一个字，拼接后剩余部分留在累加器
+    uint64_t word;
+    unsigned got = 64;
+    if (r->end - r->ptr >= 8) {
+        memcpy(&word, r->ptr, 8);
+        r->ptr += 8;
+    } else {
+        word = bitstream_load_tail(r, &got);
+    }
+    unsigned used = n - r->nacc;  // 1-64
+    v = (r->acc | (word << r->nacc)) & bitstream_mask(n);
+    r->acc = used < 64 ? word >> used : 0;
+    r->nacc = got > used ? got - used : 0;
+    return v;
+}
+
+/**
+ * @brief 从读游标拷贝 n 位到写游标
+ *
+ * 短拷贝按 64 位经过累加器；n >= 256 时先写回写游标的累加器，
+ * 再对两个游标的当前位置直接调用 bitcpy()（使用阶段2的块拷贝和 SIMD 内核），
+ * 最后把两个游标移动到拷贝之后的位置。读游标的剩余可读位数必须 >= n。
+ */
+void bitstream_copy_bits(bitstream_writer* w, bitstream_reader* r, uint64_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BITSTREAM_H
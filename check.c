@@ -3,6 +3,17 @@
 #include <string.h>
 #include <time.h>
 #include "bitcpy.h"
+#include "bitcpy_parallel.h"
+#include "bitcpy_inline.h"
+#include "bitstream.h"
+#include "bitpack.h"
+#include "bitop.h"
+#include "bitscan.h"
+#include "bitcpy_file.h"
+#include "bitcpy_async.h"
+#include "bitring.h"
+#include <pthread.h>
+#include <sched.h>
 
 // 获取指定位的值
 static inline int get_bit(const uint8_t* buf, uint64_t bit_pos) {
@@ -36,15 +47,15 @@ int verify_bitcpy(const uint8_t* src, uint8_t src_bit,
     return 1;
 }
 
-// 单次随机测试
-int run_random_test(int test_id, unsigned int seed, int verbose) {
+// 单次随机测试（len 在 [1, max_len] 内随机）
+int run_random_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
     // 设置种子以便重现
     srand(seed);
     
     // 随机参数
     uint8_t src_bit = rand() % 8;
     uint8_t dest_bit = rand() % 8;
-    uint64_t len = 1 + rand() % 200;  // 1-200位
+    uint64_t len = 1 + (uint64_t)rand() % max_len;
     
     // 计算需要的字节数
     size_t src_bytes = (src_bit + len + 7) / 8;
@@ -121,39 +132,1785 @@ int run_random_test(int test_id, unsigned int seed, int verbose) {
     return success;
 }
 
-int main() {
-    const int NUM_TESTS = 10000;
-    int passed = 0;
+// 单次随机 bitmove 测试：在同一缓冲区内移动，源和目标区间大多重叠
+int run_random_move_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint64_t len = 1 + (uint64_t)rand() % max_len;
+    uint64_t total_bits = len + (uint64_t)rand() % 128;  // 间隙小，保证大多数情况重叠
+    uint64_t src_pos = (uint64_t)rand() % (total_bits - len + 1);
+    uint64_t dest_pos = (uint64_t)rand() % (total_bits - len + 1);
+    size_t buf_bytes = (total_bits + 7) / 8;
+    
+    uint8_t* buf = (uint8_t*)malloc(buf_bytes);
+    uint8_t* orig = (uint8_t*)malloc(buf_bytes);
+    if (!buf || !orig) {
+        printf("Memory allocation failed\n");
+        free(buf);
+        free(orig);
+        return 0;
+    }
+    for (size_t i = 0; i < buf_bytes; i++) {
+        buf[i] = rand() & 0xFF;
+        orig[i] = buf[i];
+    }
+    
+    bitmove(buf + (dest_pos >> 3), dest_pos & 7, buf + (src_pos >> 3), src_pos & 7, len);
+    
+    // 逐位对比：区间内应为原始源数据，区间外应保持不变
+    int success = 1;
+    for (uint64_t i = 0; i < buf_bytes * 8; i++) {
+        int expect = (i >= dest_pos && i < dest_pos + len)
+                   ? get_bit(orig, src_pos + (i - dest_pos))
+                   : get_bit(orig, i);
+        if (get_bit(buf, i) != expect) {
+            if (verbose) {
+                printf("  [FAIL] Bit %llu mismatch: expect=%d, got=%d\n",
+                       (unsigned long long)i, expect, get_bit(buf, i));
+            }
+            success = 0;
+            break;
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Move #%d: src_pos=%llu, dest_pos=%llu, len=%llu -> %s\n",
+               test_id, (unsigned long long)src_pos, (unsigned long long)dest_pos,
+               (unsigned long long)len, success ? "PASS" : "FAIL");
+    }
+    
+    free(buf);
+    free(orig);
+    return success;
+}
+
+// 单次随机 bitcpy_batch 测试：结果应与逐个调用 bitcpy 完全一致
+int run_random_batch_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    size_t n = 1 + (size_t)rand() % 2048;  // 覆盖跨越 1024 个描述符窗口的情况
+    bitcpy_desc* descs = (bitcpy_desc*)calloc(n, sizeof(bitcpy_desc));
+    uint8_t** expect = (uint8_t**)calloc(n, sizeof(uint8_t*));
+    size_t* dest_bytes = (size_t*)calloc(n, sizeof(size_t));
+    int success = descs && expect && dest_bytes;
+    
+    for (size_t i = 0; success && i < n; i++) {
+        uint8_t src_bit = rand() % 8;
+        uint8_t dest_bit = rand() % 8;
+        uint64_t len = (uint64_t)rand() % (max_len + 1);  // 包含 len == 0
+        size_t src_bytes = (src_bit + len + 7) / 8;
+        dest_bytes[i] = (dest_bit + len + 7) / 8;
+        
+        uint8_t* src = (uint8_t*)malloc(src_bytes);
+        uint8_t* dest = (uint8_t*)malloc(dest_bytes[i]);
+        expect[i] = (uint8_t*)malloc(dest_bytes[i]);
+        descs[i].src = src;
+        descs[i].dest = dest;
+        if (!src || !dest || !expect[i]) {
+            printf("Memory allocation failed\n");
+            success = 0;
+            break;
+        }
+        for (size_t j = 0; j < src_bytes; j++) {
+            src[j] = rand() & 0xFF;
+        }
+        for (size_t j = 0; j < dest_bytes[i]; j++) {
+            dest[j] = rand() & 0xFF;
+            expect[i][j] = dest[j];
+        }
+        descs[i].dest_bit = dest_bit;
+        descs[i].src_bit = src_bit;
+        descs[i].len = len;
+        bitcpy(expect[i], dest_bit, src, src_bit, len);
+    }
+    
+    if (success) {
+        bitcpy_batch(descs, n);
+        for (size_t i = 0; i < n; i++) {
+            if (memcmp(descs[i].dest, expect[i], dest_bytes[i]) != 0) {
+                if (verbose) {
+                    printf("  [FAIL] Descriptor %llu: src_bit=%d, dest_bit=%d, len=%llu\n",
+                           (unsigned long long)i, descs[i].src_bit, descs[i].dest_bit,
+                           (unsigned long long)descs[i].len);
+                }
+                success = 0;
+                break;
+            }
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Batch #%d: descriptors=%llu -> %s\n",
+               test_id, (unsigned long long)n, success ? "PASS" : "FAIL");
+    }
+    
+    for (size_t i = 0; descs && expect && i < n; i++) {
+        free((void*)descs[i].src);
+        free(descs[i].dest);
+        free(expect[i]);
+    }
+    free(descs);
+    free(expect);
+    free(dest_bytes);
+    return success;
+}
+
+typedef void (*copy_fn)(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+// 单次随机对比测试：copy 的结果应与 bitcpy 逐字节一致（包括首尾保留的位）
+int run_compare_test(const char* name, copy_fn copy, int test_id, unsigned int seed,
+                     uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t src_bit = rand() % 8;
+    uint8_t dest_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dest_bytes);
+    if (!src || !dest || !expect) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dest_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    
+    bitcpy(expect, dest_bit, src, src_bit, len);
+    copy(dest, dest_bit, src, src_bit, len);
+    
+    int success = memcmp(dest, expect, dest_bytes) == 0;
+    if (!success || verbose) {
+        printf("%s #%d: src_bit=%d, dest_bit=%d, len=%llu -> %s\n",
+               name, test_id, src_bit, dest_bit, (unsigned long long)len,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    return success;
+}
+
+int run_random_parallel_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    if (test_id == 1) {
+        // len == 0：即使阈值为 0、指针为 NULL 或目标按 64 字节对齐，也应立即返回
+        static uint8_t zero_buf[64] __attribute__((aligned(64)));
+        memset(zero_buf, 0xA5, sizeof(zero_buf));
+        bitcpy_parallel(NULL, 0, NULL, 0, 0);
+        bitcpy_parallel(zero_buf, 0, zero_buf + 8, 3, 0);
+        int success = 1;
+        for (size_t i = 0; i < sizeof(zero_buf); i++) {
+            if (zero_buf[i] != 0xA5) success = 0;
+        }
+        if (!success || verbose) {
+            printf("Parallel #%d: len=0 -> %s\n", test_id, success ? "PASS" : "FAIL");
+        }
+        if (!success) return 0;
+    }
+    return run_compare_test("Parallel", bitcpy_parallel, test_id, seed, max_len, verbose);
+}
+
+int run_random_stream_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    return run_compare_test("Stream", bitcpy_stream, test_id, seed, max_len, verbose);
+}
+
+// 单次 bitcpy_fixed / BITCPY_INLINE 测试：用恰好够用的缓冲区与 bitcpy 对比
+// copy 非空时通过它调用常量参数的 BITCPY_INLINE（由 CHECK_INLINE 展开），否则直接调用 bitcpy_fixed
+int check_fixed_case(uint8_t dest_bit, uint8_t src_bit, uint64_t len,
+                     void (*copy)(uint8_t*, const uint8_t*)) {
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dest_bytes);
+    int success = src && dest && expect;
+    
+    if (success) {
+        for (size_t i = 0; i < src_bytes; i++) {
+            src[i] = rand() & 0xFF;
+        }
+        for (size_t i = 0; i < dest_bytes; i++) {
+            dest[i] = rand() & 0xFF;
+            expect[i] = dest[i];
+        }
+        bitcpy(expect, dest_bit, src, src_bit, len);
+        if (copy) {
+            copy(dest, src);
+        } else {
+            bitcpy_fixed(dest, dest_bit, src, src_bit, len);
+        }
+        success = memcmp(dest, expect, dest_bytes) == 0;
+    }
+    if (!success) {
+        printf("Fixed %s: src_bit=%d, dest_bit=%d, len=%llu -> FAIL\n",
+               copy ? "BITCPY_INLINE" : "bitcpy_fixed", src_bit, dest_bit,
+               (unsigned long long)len);
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    return success;
+}
+
+#define CHECK_INLINE(DB, SB, LEN)                                        \
+    static void inline_copy_##DB##_##SB##_##LEN(uint8_t* d, const uint8_t* s) { \
+        BITCPY_INLINE(d, DB, s, SB, LEN);                                \
+    }
+CHECK_INLINE(0, 0, 3)
+CHECK_INLINE(5, 2, 3)
+CHECK_INLINE(7, 7, 12)
+CHECK_INLINE(3, 6, 17)
+CHECK_INLINE(0, 0, 48)
+CHECK_INLINE(7, 1, 48)
+CHECK_INLINE(1, 7, 64)
+CHECK_INLINE(2, 3, 100)  // 超过 64 位，退回 bitcpy()
+
+// 穷举 bitcpy_fixed 的全部 (dest_bit, src_bit, len<=64) 组合，再检查常量展开的 BITCPY_INLINE
+int run_fixed_tests(unsigned int seed, int* total) {
     int failed = 0;
+    srand(seed);
+    printf("Running exhaustive bitcpy_fixed tests (len 1-64, seed=%u)...\n\n", seed);
+    
+    for (uint8_t dest_bit = 0; dest_bit < 8; dest_bit++) {
+        for (uint8_t src_bit = 0; src_bit < 8; src_bit++) {
+            for (uint64_t len = 1; len <= 64; len++) {
+                failed += !check_fixed_case(dest_bit, src_bit, len, NULL);
+                (*total)++;
+            }
+        }
+    }
+    
+    static const struct {
+        uint8_t dest_bit, src_bit;
+        uint64_t len;
+        void (*copy)(uint8_t*, const uint8_t*);
+    } cases[] = {
+        {0, 0, 3, inline_copy_0_0_3},   {5, 2, 3, inline_copy_5_2_3},
+        {7, 7, 12, inline_copy_7_7_12}, {3, 6, 17, inline_copy_3_6_17},
+        {0, 0, 48, inline_copy_0_0_48}, {7, 1, 48, inline_copy_7_1_48},
+        {1, 7, 64, inline_copy_1_7_64}, {2, 3, 100, inline_copy_2_3_100},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += !check_fixed_case(cases[i].dest_bit, cases[i].src_bit, cases[i].len,
+                                    cases[i].copy);
+        (*total)++;
+    }
+    return failed;
+}
+
+// 单次随机位流测试：随机交替写入常量字段、逐字段转发和 bitstream_copy_bits，
+// 与逐位构造的期望结果对比；读出的每个字段也与源数据逐位对比
+int run_random_bitstream_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    const int MAX_LITERALS = 200;
+    uint8_t src_bit = rand() % 8;
+    uint8_t dest_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 64 * MAX_LITERALS + 7) / 8;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dest_bytes);
+    if (!src || !dest || !expect) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    // 可读范围结束在字节中间时，末字节范围之外的高位全部置 1，读出时应为 0
+    if ((src_bit + len) % 8 != 0) {
+        src[src_bytes - 1] |= (uint8_t)(0xFF << ((src_bit + len) % 8));
+    }
+    for (size_t i = 0; i < dest_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    
+    bitstream_writer w;
+    bitstream_reader r;
+    bitstream_writer_init(&w, dest, dest_bit);
+    bitstream_reader_init(&r, src, src_bit, len);
+    
+    int success = 1;
+    int literals = 0;
+    uint64_t read_pos = src_bit;
+    uint64_t write_pos = dest_bit;
+    while (success && read_pos < src_bit + len) {
+        uint64_t left = src_bit + len - read_pos;
+        int op = rand() % 3;
+        if (op == 0 && literals < MAX_LITERALS) {
+            // 写入常量字段
+            unsigned n = rand() % 65;
+            uint64_t v = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+            bitstream_put_bits(&w, v, n);
+            for (unsigned i = 0; i < n; i++) {
+                set_bit(expect, write_pos++, (int)((v >> i) & 1));
+            }
+            literals++;
+        } else if (op == 1) {
+            // 读出一个字段再写入
+            unsigned n = (unsigned)(rand() % 65);
+            if (n > left) n = (unsigned)left;
+            uint64_t v = bitstream_get_bits(&r, n);
+            for (unsigned i = 0; i < n; i++) {
+                if ((int)((v >> i) & 1) != get_bit(src, read_pos + i)) {
+                    if (verbose) {
+                        printf("  [FAIL] get_bits(%u) at bit %llu returned wrong data\n",
+                               n, (unsigned long long)read_pos);
+                    }
+                    success = 0;
+                    break;
+                }
+                set_bit(expect, write_pos + i, get_bit(src, read_pos + i));
+            }
+            bitstream_put_bits(&w, v, n);
+            read_pos += n;
+            write_pos += n;
+        } else {
+            // 直接拷贝一段，覆盖短拷贝和 bitcpy 两条路径
+            uint64_t n = 1 + (uint64_t)rand() % 2000;
+            if (n > left) n = left;
+            bitstream_copy_bits(&w, &r, n);
+            for (uint64_t i = 0; i < n; i++) {
+                set_bit(expect, write_pos + i, get_bit(src, read_pos + i));
+            }
+            read_pos += n;
+            write_pos += n;
+        }
+        if (bitstream_reader_tell(&r) != read_pos || bitstream_writer_tell(&w) != write_pos) {
+            if (verbose) {
+                printf("  [FAIL] Cursor position mismatch: read %llu/%llu, write %llu/%llu\n",
+                       (unsigned long long)bitstream_reader_tell(&r), (unsigned long long)read_pos,
+                       (unsigned long long)bitstream_writer_tell(&w), (unsigned long long)write_pos);
+            }
+            success = 0;
+        }
+    }
+    bitstream_writer_flush(&w);
+    
+    if (success && bitstream_get_bits(&r, 64) != 0) {
+        if (verbose) {
+            printf("  [FAIL] Bits past the end of the range are not 0\n");
+        }
+        success = 0;
+    }
+    if (success && memcmp(dest, expect, dest_bytes) != 0) {
+        if (verbose) {
+            printf("  [FAIL] Output stream mismatch\n");
+        }
+        success = 0;
+    }
+    if (!success || verbose) {
+        printf("Bitstream #%d: src_bit=%d, dest_bit=%d, len=%llu -> %s\n",
+               test_id, src_bit, dest_bit, (unsigned long long)len,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    return success;
+}
+
+// 随机测试位打包/解包：max_len 为值个数上限，随机选择 32/64 位版本和宽度
+int run_random_bitpack_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    int elem64 = rand() & 1;
+    unsigned width = 1 + rand() % (elem64 ? 64 : 32);
+    uint8_t bit = rand() % 8;
+    size_t n = (size_t)(1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len);
+    size_t bytes = (bit + (uint64_t)n * width + 7) / 8;
+    
+    // 分配恰好 bytes 字节，越界访问由 ASan 发现
+    uint64_t* values = (uint64_t*)malloc(n * sizeof(uint64_t));
+    uint64_t* unpacked = (uint64_t*)malloc(n * sizeof(uint64_t));
+    uint8_t* buf = (uint8_t*)malloc(bytes);
+    uint8_t* orig = (uint8_t*)malloc(bytes);
+    if (!values || !unpacked || !buf || !orig) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(unpacked);
+        free(buf);
+        free(orig);
+        return 0;
+    }
+    uint32_t* values32 = (uint32_t*)values;
+    uint32_t* unpacked32 = (uint32_t*)unpacked;
+    for (size_t i = 0; i < n; i++) {
+        // 高于 width 的位应被忽略
+        uint64_t v = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+        if (elem64) {
+            values[i] = v;
+        } else {
+            values32[i] = (uint32_t)v;
+        }
+    }
+    for (size_t i = 0; i < bytes; i++) {
+        buf[i] = rand() & 0xFF;
+        orig[i] = buf[i];
+    }
+    
+    if (elem64) {
+        bitpack64(buf, bit, values, n, width);
+    } else {
+        bitpack32(buf, bit, values32, n, width);
+    }
+    
+    int success = 1;
+    // 区间内的位等于对应值的位，区间外的位保持不变
+    for (uint64_t pos = 0; success && pos < (uint64_t)bytes * 8; pos++) {
+        int expect;
+        if (pos < bit || pos >= bit + (uint64_t)n * width) {
+            expect = get_bit(orig, pos);
+        } else {
+            uint64_t i = (pos - bit) / width;
+            unsigned k = (unsigned)((pos - bit) % width);
+            uint64_t v = elem64 ? values[i] : values32[i];
+            expect = (int)((v >> k) & 1);
+        }
+        if (get_bit(buf, pos) != expect) {
+            if (verbose) {
+                printf("  [FAIL] Packed bit %llu mismatch\n", (unsigned long long)pos);
+            }
+            success = 0;
+        }
+    }
+    
+    if (success) {
+        uint64_t mask = width >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+        if (elem64) {
+            bitunpack64(unpacked, buf, bit, n, width);
+        } else {
+            bitunpack32(unpacked32, buf, bit, n, width);
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint64_t got = elem64 ? unpacked[i] : unpacked32[i];
+            uint64_t want = (elem64 ? values[i] : values32[i]) & mask;
+            if (got != want) {
+                if (verbose) {
+                    printf("  [FAIL] Unpacked value %zu: got 0x%llx, expected 0x%llx\n",
+                           i, (unsigned long long)got, (unsigned long long)want);
+                }
+                success = 0;
+                break;
+            }
+        }
+    }
+    if (!success || verbose) {
+        printf("Bitpack #%d: %s, bit=%d, width=%u, n=%zu -> %s\n",
+               test_id, elem64 ? "64" : "32", bit, width, n, success ? "PASS" : "FAIL");
+    }
+    
+    free(values);
+    free(unpacked);
+    free(buf);
+    free(orig);
+    return success;
+}
+
+// 单次随机 bitop 测试：逐位与参考结果对比；约四分之一的测试原地运算（dest 与 a 为同一位区间）
+int run_random_bitop_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    static const char* op_names[] = {"AND", "OR", "XOR", "NOT"};
+    bitop_kind op = (bitop_kind)(rand() % 4);
+    int in_place = rand() % 4 == 0;
+    uint8_t a_bit = rand() % 8;
+    uint8_t b_bit = rand() % 8;
+    uint8_t dest_bit = in_place ? a_bit : rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t a_bytes = (a_bit + len + 7) / 8;
+    size_t b_bytes = (b_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    
+    uint8_t* a = (uint8_t*)malloc(a_bytes);
+    uint8_t* b = (uint8_t*)malloc(b_bytes);
+    uint8_t* orig_a = (uint8_t*)malloc(a_bytes);
+    uint8_t* dest = in_place ? a : (uint8_t*)malloc(dest_bytes);
+    uint8_t* orig_dest = (uint8_t*)malloc(dest_bytes);
+    if (!a || !b || !orig_a || !dest || !orig_dest) {
+        printf("Memory allocation failed\n");
+        free(a);
+        free(b);
+        free(orig_a);
+        if (!in_place) free(dest);
+        free(orig_dest);
+        return 0;
+    }
+    for (size_t i = 0; i < a_bytes; i++) {
+        a[i] = rand() & 0xFF;
+        orig_a[i] = a[i];
+    }
+    for (size_t i = 0; i < b_bytes; i++) {
+        b[i] = rand() & 0xFF;
+    }
+    if (!in_place) {
+        for (size_t i = 0; i < dest_bytes; i++) {
+            dest[i] = rand() & 0xFF;
+        }
+    }
+    memcpy(orig_dest, dest, dest_bytes);
+    
+    bitop(dest, dest_bit, a, a_bit, op == BITOP_NOT ? NULL : b, b_bit, len, op);
+    
+    int success = 1;
+    for (uint64_t i = 0; i < dest_bytes * 8; i++) {
+        int expect = get_bit(orig_dest, i);
+        if (i >= dest_bit && i < dest_bit + len) {
+            int x = get_bit(orig_a, a_bit + (i - dest_bit));
+            int y = get_bit(b, b_bit + (i - dest_bit));
+            switch (op) {
+            case BITOP_AND: expect = x & y; break;
+            case BITOP_OR:  expect = x | y; break;
+            case BITOP_XOR: expect = x ^ y; break;
+            case BITOP_NOT: expect = !x; break;
+            }
+        }
+        if (get_bit(dest, i) != expect) {
+            if (verbose) {
+                printf("  [FAIL] Bit %llu mismatch: expect=%d, got=%d\n",
+                       (unsigned long long)i, expect, get_bit(dest, i));
+            }
+            success = 0;
+            break;
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Bitop #%d: %s%s, a_bit=%d, b_bit=%d, dest_bit=%d, len=%llu -> %s\n",
+               test_id, op_names[op], in_place ? " (in place)" : "", a_bit, b_bit, dest_bit,
+               (unsigned long long)len, success ? "PASS" : "FAIL");
+    }
+    
+    free(a);
+    free(b);
+    free(orig_a);
+    if (!in_place) free(dest);
+    free(orig_dest);
+    return success;
+}
+
+// 单次随机 bitblit 测试：宽度随机到 max_len，x 偏移和行步长随机，与逐位计算的期望结果对比；
+// 位图恰好分配到最后一行矩形的末字节，越界访问由 ASan 发现，矩形之外（包括行间）的位保持不变
+int run_random_blit_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    static const char* rop_names[] = {"COPY", "AND", "OR", "XOR", "ANDNOT"};
+    bitblit_rop rop = (bitblit_rop)(rand() % 5);
+    uint64_t width = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    uint64_t height = 1 + rand() % 12;
+    uint64_t dst_x = rand() % 80;
+    uint64_t src_x = rand() % 80;
+    size_t dst_stride = (size_t)((dst_x + width + 7) / 8) + rand() % 5;
+    size_t src_stride = (size_t)((src_x + width + 7) / 8) + rand() % 5;
+    size_t dst_bytes = (height - 1) * dst_stride + (size_t)((dst_x + width + 7) / 8);
+    size_t src_bytes = (height - 1) * src_stride + (size_t)((src_x + width + 7) / 8);
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dst = (uint8_t*)malloc(dst_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dst_bytes);
+    if (!src || !dst || !expect) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dst);
+        free(expect);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dst_bytes; i++) {
+        dst[i] = rand() & 0xFF;
+        expect[i] = dst[i];
+    }
+    for (uint64_t y = 0; y < height; y++) {
+        for (uint64_t i = 0; i < width; i++) {
+            uint64_t dp = y * dst_stride * 8 + dst_x + i;
+            int d = get_bit(expect, dp);
+            int x = get_bit(src, y * src_stride * 8 + src_x + i);
+            switch (rop) {
+            case BITBLIT_COPY:   d = x; break;
+            case BITBLIT_AND:    d &= x; break;
+            case BITBLIT_OR:     d |= x; break;
+            case BITBLIT_XOR:    d ^= x; break;
+            case BITBLIT_ANDNOT: d &= !x; break;
+            }
+            set_bit(expect, dp, d);
+        }
+    }
+    
+    bitblit(dst, dst_stride, dst_x, src, src_stride, src_x, width, height, rop);
+    int success = memcmp(dst, expect, dst_bytes) == 0;
+    
+    if (!success || verbose) {
+        printf("Bitblit #%d: %s, %llux%llu, dst_x=%llu/stride %llu, src_x=%llu/stride %llu -> %s\n",
+               test_id, rop_names[rop], (unsigned long long)width, (unsigned long long)height,
+               (unsigned long long)dst_x, (unsigned long long)dst_stride,
+               (unsigned long long)src_x, (unsigned long long)src_stride,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dst);
+    free(expect);
+    return success;
+}
+
+// 单次随机 bitcount/bitfind 测试：数据大多为同一个值，只有少数几位相反，覆盖长距离跳过和未找到的情况
+int run_random_scan_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t src_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    uint8_t fill = (rand() & 1) ? 0xFF : 0x00;
+    int flips = rand() % 4;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    if (!src) {
+        printf("Memory allocation failed\n");
+        return 0;
+    }
+    if (rand() % 4 == 0) {
+        // 随机数据：主要测试计数
+        for (size_t i = 0; i < src_bytes; i++) {
+            src[i] = rand() & 0xFF;
+        }
+    } else {
+        memset(src, fill, src_bytes);
+        for (int i = 0; i < flips; i++) {
+            uint64_t pos = ((uint64_t)rand() * RAND_MAX + rand()) % (src_bytes * 8);
+            set_bit(src, pos, !get_bit(src, pos));
+        }
+    }
+    
+    uint64_t expect_count = 0;
+    uint64_t expect_set = len;
+    uint64_t expect_clear = len;
+    for (uint64_t i = 0; i < len; i++) {
+        int bit = get_bit(src, src_bit + i);
+        expect_count += bit;
+        if (bit && expect_set == len) expect_set = i;
+        if (!bit && expect_clear == len) expect_clear = i;
+    }
+    uint64_t count = bitcount(src, src_bit, len);
+    uint64_t found_set = bitfind_set(src, src_bit, len);
+    uint64_t found_clear = bitfind_clear(src, src_bit, len);
+    
+    int success = count == expect_count && found_set == expect_set && found_clear == expect_clear;
+    if (!success || verbose) {
+        printf("Scan #%d: src_bit=%d, len=%llu, count=%llu/%llu, set=%llu/%llu, clear=%llu/%llu -> %s\n",
+               test_id, src_bit, (unsigned long long)len,
+               (unsigned long long)count, (unsigned long long)expect_count,
+               (unsigned long long)found_set, (unsigned long long)expect_set,
+               (unsigned long long)found_clear, (unsigned long long)expect_clear,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    return success;
+}
+
+// 单次随机 bitfill 测试：边界附近逐位对比，中间的整字节只检查是否等于填充值
+int run_random_fill_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t dest_bit = rand() % 8;
+    int value = rand() & 1;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    
+    // 偏移 0-63 字节，覆盖非临时存储首部的各种对齐
+    size_t shift = rand() % 64;
+    uint8_t* block = (uint8_t*)malloc(dest_bytes + shift);
+    uint8_t* orig = (uint8_t*)malloc(dest_bytes);
+    if (!block || !orig) {
+        printf("Memory allocation failed\n");
+        free(block);
+        free(orig);
+        return 0;
+    }
+    uint8_t* dest = block + shift;
+    for (size_t i = 0; i < dest_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        orig[i] = dest[i];
+    }
+    
+    bitfill(dest, dest_bit, len, value);
+    
+    int success = 1;
+    uint64_t end = dest_bit + len;
+    for (size_t i = 0; success && i < dest_bytes; i++) {
+        if (i >= 16 && i + 16 < dest_bytes) {
+            if (dest[i] != (value ? 0xFF : 0x00)) {
+                if (verbose) {
+                    printf("  [FAIL] Byte %zu = 0x%02x\n", i, dest[i]);
+                }
+                success = 0;
+            }
+            continue;
+        }
+        for (uint64_t pos = (uint64_t)i * 8; pos < (uint64_t)i * 8 + 8; pos++) {
+            int expect = (pos >= dest_bit && pos < end) ? value : get_bit(orig, pos);
+            if (get_bit(dest, pos) != expect) {
+                if (verbose) {
+                    printf("  [FAIL] Bit %llu mismatch: expect=%d, got=%d\n",
+                           (unsigned long long)pos, expect, get_bit(dest, pos));
+                }
+                success = 0;
+                break;
+            }
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Fill #%d: dest_bit=%d, len=%llu, value=%d, shift=%zu -> %s\n",
+               test_id, dest_bit, (unsigned long long)len, value, shift,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(block);
+    free(orig);
+    return success;
+}
+
+// 单次随机 bitcmp 测试：b 为 a 的拷贝，随机翻转区间内的一位或区间外的位
+int run_random_cmp_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t a_bit = rand() % 8;
+    uint8_t b_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t a_bytes = (a_bit + len + 7) / 8;
+    size_t b_bytes = (b_bit + len + 7) / 8;
+    
+    uint8_t* a = (uint8_t*)malloc(a_bytes);
+    uint8_t* b = (uint8_t*)malloc(b_bytes);
+    if (!a || !b) {
+        printf("Memory allocation failed\n");
+        free(a);
+        free(b);
+        return 0;
+    }
+    for (size_t i = 0; i < a_bytes; i++) {
+        a[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < b_bytes; i++) {
+        b[i] = rand() & 0xFF;
+    }
+    bitcpy(b, b_bit, a, a_bit, len);
+    int mode = rand() % 3;
+    if (mode == 1) {
+        uint64_t pos = ((uint64_t)rand() * RAND_MAX + rand()) % len;
+        set_bit(b, b_bit + pos, !get_bit(b, b_bit + pos));
+    } else if (mode == 2) {
+        // 区间外的位不影响结果
+        a[0] ^= (uint8_t)((1u << a_bit) - 1);
+        b[b_bytes - 1] ^= (uint8_t)(0xFF << ((b_bit + len - 1) % 8 + 1) & 0xFF);
+    }
+    
+    uint64_t expect_diff = len;
+    int expect = 0;
+    for (uint64_t i = 0; i < len; i++) {
+        int x = get_bit(a, a_bit + i);
+        int y = get_bit(b, b_bit + i);
+        if (x != y) {
+            expect_diff = i;
+            expect = x ? 1 : -1;
+            break;
+        }
+    }
+    uint64_t diff = 0;
+    int result = bitcmp(a, a_bit, b, b_bit, len, &diff);
+    int equal = bitequal(a, a_bit, b, b_bit, len);
+    
+    int success = result == expect && diff == expect_diff && equal == (expect == 0);
+    if (!success || verbose) {
+        printf("Cmp #%d: a_bit=%d, b_bit=%d, len=%llu, result=%d/%d, diff=%llu/%llu, equal=%d -> %s\n",
+               test_id, a_bit, b_bit, (unsigned long long)len, result, expect,
+               (unsigned long long)diff, (unsigned long long)expect_diff, equal,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(a);
+    free(b);
+    return success;
+}
+
+// MSB 优先位序的逐位参考：位 0 是字节的最高有效位
+static inline int get_bit_msb(const uint8_t* buf, uint64_t bit_pos) {
+    return (buf[bit_pos >> 3] >> (7 - (bit_pos & 7))) & 1;
+}
+
+static inline void set_bit_msb(uint8_t* buf, uint64_t bit_pos, int val) {
+    uint8_t mask = (uint8_t)(0x80 >> (bit_pos & 7));
+    if (val) {
+        buf[bit_pos >> 3] |= mask;
+    } else {
+        buf[bit_pos >> 3] &= (uint8_t)~mask;
+    }
+}
+
+// 单次随机 bitcpy_msb 测试：与 MSB 位序的逐位参考拷贝整块对比
+int run_random_msb_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t src_bit = rand() % 8;
+    uint8_t dest_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dest_bytes);
+    if (!src || !dest || !expect) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dest_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    for (uint64_t i = 0; i < len; i++) {
+        set_bit_msb(expect, dest_bit + i, get_bit_msb(src, src_bit + i));
+    }
+    
+    bitcpy_msb(dest, dest_bit, src, src_bit, len);
+    
+    int success = 1;
+    for (size_t i = 0; i < dest_bytes; i++) {
+        if (dest[i] != expect[i]) {
+            if (verbose) {
+                printf("  [FAIL] Byte %zu mismatch: expect=0x%02x, got=0x%02x\n",
+                       i, expect[i], dest[i]);
+            }
+            success = 0;
+            break;
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("MSB #%d: src_bit=%d, dest_bit=%d, len=%llu -> %s\n",
+               test_id, src_bit, dest_bit, (unsigned long long)len,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    return success;
+}
+
+// 单次随机文件拷贝测试：源和目标都是临时文件，起始位在文件中任意位置；
+// 目标文件有时短于目标区间（检查扩展部分为 0），拷贝后读回整个目标文件与期望结果对比
+int run_random_file_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint64_t src_bit = (uint64_t)rand() % 40000;
+    uint64_t dst_bit = (uint64_t)rand() % 40000;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t src_bytes = (size_t)((src_bit + len + 7) / 8 + rand() % 16);
+    size_t dst_need = (size_t)((dst_bit + len + 7) / 8);
+    size_t dst_bytes = rand() % 4 == 0 ? (size_t)rand() % (dst_need + 1) : dst_need + rand() % 16;
+    size_t total_bytes = dst_bytes > dst_need ? dst_bytes : dst_need;
+    
+    FILE* src_file = tmpfile();
+    FILE* dst_file = tmpfile();
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* expect = (uint8_t*)calloc(total_bytes, 1);
+    uint8_t* result = (uint8_t*)malloc(total_bytes);
+    if (!src_file || !dst_file || !src || !expect || !result) {
+        printf("Temporary file or memory allocation failed\n");
+        if (src_file) fclose(src_file);
+        if (dst_file) fclose(dst_file);
+        free(src);
+        free(expect);
+        free(result);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dst_bytes; i++) {
+        expect[i] = rand() & 0xFF;
+    }
+    int success = fwrite(src, 1, src_bytes, src_file) == src_bytes &&
+                  fwrite(expect, 1, dst_bytes, dst_file) == dst_bytes &&
+                  fflush(src_file) == 0 && fflush(dst_file) == 0;
+    for (uint64_t i = 0; i < len; i++) {
+        set_bit(expect, dst_bit + i, get_bit(src, src_bit + i));
+    }
+    
+    int ret = -1;
+    if (success) {
+        ret = bitcpy_file(fileno(dst_file), dst_bit, fileno(src_file), src_bit, len);
+        success = ret == 0 && fseek(dst_file, 0, SEEK_SET) == 0 &&
+                  fread(result, 1, total_bytes, dst_file) == total_bytes &&
+                  memcmp(result, expect, total_bytes) == 0;
+    }
+    
+    if (!success || verbose) {
+        printf("Test #%d: src_bit=%llu, dst_bit=%llu, len=%llu, dst file %llu bytes, ret=%d -> %s\n",
+               test_id, (unsigned long long)src_bit, (unsigned long long)dst_bit,
+               (unsigned long long)len, (unsigned long long)dst_bytes, ret,
+               success ? "PASS" : "FAIL");
+    }
+    
+    fclose(src_file);
+    fclose(dst_file);
+    free(src);
+    free(expect);
+    free(result);
+    return success;
+}
+
+// 单次随机插入/删除测试：在随机位置插入随机数据或 0，再删除随机一段，每一步都与逐位构造的期望结果对比
+int run_random_splice_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint64_t used = ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    uint64_t pos = used ? ((uint64_t)rand() * RAND_MAX + rand()) % (used + 1) : 0;
+    uint64_t k = 1 + (rand() % 4 == 0 ? (uint64_t)rand() % max_len : (uint64_t)rand() % 70);
+    uint8_t src_bit = rand() % 8;
+    int zeros = rand() % 4 == 0;
+    size_t buf_bytes = (used + k + 7) / 8;
+    size_t src_bytes = (src_bit + k + 7) / 8;
+    
+    uint8_t* buf = (uint8_t*)malloc(buf_bytes);
+    uint8_t* expect = (uint8_t*)malloc(buf_bytes);
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    if (!buf || !expect || !src) {
+        printf("Memory allocation failed\n");
+        free(buf);
+        free(expect);
+        free(src);
+        return 0;
+    }
+    for (size_t i = 0; i < buf_bytes; i++) {
+        buf[i] = rand() & 0xFF;
+        expect[i] = buf[i];
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    
+    // 插入：[pos + k, used + k) 来自原来的 [pos, used)，[pos, pos + k) 来自 src
+    for (uint64_t i = used; i > pos; i--) {
+        set_bit(expect, i - 1 + k, get_bit(buf, i - 1));
+    }
+    for (uint64_t i = 0; i < k; i++) {
+        set_bit(expect, pos + i, zeros ? 0 : get_bit(src, src_bit + i));
+    }
+    bitinsert(buf, used, pos, zeros ? NULL : src, src_bit, k);
+    int insert_ok = memcmp(buf, expect, buf_bytes) == 0;
     
-    // 使用时间作为基础种子
-    unsigned int base_seed = (unsigned int)time(NULL);
+    // 删除：[dpos, used + k - dk) 来自原来的 [dpos + dk, used + k)，之后的位不变
+    uint64_t total = used + k;
+    uint64_t dpos = ((uint64_t)rand() * RAND_MAX + rand()) % (total + 1);
+    uint64_t dk = ((uint64_t)rand() * RAND_MAX + rand()) % (total - dpos + 1);
+    for (uint64_t i = dpos; i + dk < total; i++) {
+        set_bit(expect, i, get_bit(expect, i + dk));
+    }
+    bitdelete(buf, total, dpos, dk);
+    int delete_ok = memcmp(buf, expect, buf_bytes) == 0;
     
-    printf("Running %d random bitcpy tests (seed=%u)...\n\n", NUM_TESTS, base_seed);
+    int success = insert_ok && delete_ok;
+    if (!success || verbose) {
+        printf("Test #%d: used=%llu, insert %llu bits at %llu (%s) -> %s, "
+               "delete %llu bits at %llu -> %s\n",
+               test_id, (unsigned long long)used, (unsigned long long)k,
+               (unsigned long long)pos, zeros ? "zeros" : "data", insert_ok ? "PASS" : "FAIL",
+               (unsigned long long)dk, (unsigned long long)dpos, delete_ok ? "PASS" : "FAIL");
+    }
     
-    for (int i = 1; i <= NUM_TESTS; i++) {
-        unsigned int test_seed = base_seed + i;
+    free(buf);
+    free(expect);
+    free(src);
+    return success;
+}
+
+// 单次随机展开/压缩测试：bits_to_bytes 与逐位读取对比；bytes_to_bits 的输入混合 0、1 和其他非 0 值，
+// 与逐位构造的期望结果对比，区间之外的位保持不变
+int run_random_expand_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t bit_bytes = (bit + len + 7) / 8;
+    
+    // 分配恰好需要的字节数，越界访问由 ASan 发现
+    uint8_t* src = (uint8_t*)malloc(bit_bytes);
+    uint8_t* dest = (uint8_t*)malloc(bit_bytes);
+    uint8_t* expect = (uint8_t*)malloc(bit_bytes);
+    uint8_t* expanded = (uint8_t*)malloc(len);
+    uint8_t* values = (uint8_t*)malloc(len);
+    if (!src || !dest || !expect || !expanded || !values) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        free(expanded);
+        free(values);
+        return 0;
+    }
+    for (size_t i = 0; i < bit_bytes; i++) {
+        src[i] = rand() & 0xFF;
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    for (uint64_t i = 0; i < len; i++) {
+        int r = rand() % 4;
+        values[i] = r == 0 ? 0 : r == 1 ? 1 : (uint8_t)rand();
+        set_bit(expect, bit + i, values[i] != 0);
+    }
+    
+    int expand_ok = 1;
+    bits_to_bytes(expanded, src, bit, len);
+    for (uint64_t i = 0; i < len; i++) {
+        if (expanded[i] != get_bit(src, bit + i)) {
+            if (verbose) {
+                printf("  [FAIL] bits_to_bytes byte %llu = %u\n", (unsigned long long)i, expanded[i]);
+            }
+            expand_ok = 0;
+            break;
+        }
+    }
+    bytes_to_bits(dest, bit, values, len);
+    int compact_ok = memcmp(dest, expect, bit_bytes) == 0;
+    int success = expand_ok && compact_ok;
+    
+    if (!success || verbose) {
+        printf("Test #%d: bit=%d, len=%llu, expand %s, compact %s\n",
+               test_id, bit, (unsigned long long)len,
+               expand_ok ? "PASS" : "FAIL", compact_ok ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    free(expanded);
+    free(values);
+    return success;
+}
+
+// 单次随机布局转换测试：字段在两种布局中按各自的顺序排列，间隙随机为 0，使部分字段可以合并；
+// 与逐记录逐字段调用 bitcpy() 对比，缓冲区恰好为 nrecords * stride 字节，覆盖末尾记录的越界保护
+#define PLAN_TEST_MAX_FIELDS 24
+
+int run_random_plan_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    bitcpy_field fields[PLAN_TEST_MAX_FIELDS];
+    int order[PLAN_TEST_MAX_FIELDS];
+    size_t n = 1 + rand() % PLAN_TEST_MAX_FIELDS;
+    for (size_t i = 0; i < n; i++) {
+        fields[i].len = rand() % 8 == 0 ? 1 + (uint64_t)rand() % max_len : 1 + (uint64_t)(rand() % 70);
+        order[i] = (int)i;
+    }
+    // 源布局的字段顺序：目标顺序上做几次随机交换
+    for (int k = rand() % 4; k > 0; k--) {
+        int a = rand() % (int)n, b = rand() % (int)n;
+        int t = order[a];
+        order[a] = order[b];
+        order[b] = t;
+    }
+    uint64_t dst_pos = rand() % 16, src_pos = rand() % 16;
+    for (size_t i = 0; i < n; i++) {
+        fields[i].dst_off = dst_pos;
+        dst_pos += fields[i].len + (rand() % 2 ? 0 : rand() % 20);
+        fields[order[i]].src_off = src_pos;
+        src_pos += fields[order[i]].len + (rand() % 2 ? 0 : rand() % 20);
+    }
+    size_t src_stride = (size_t)((src_pos + 7) / 8) + rand() % 3;
+    size_t dst_stride = (size_t)((dst_pos + 7) / 8) + rand() % 3;
+    size_t nrecords = 1 + rand() % 20;
+    size_t src_bytes = nrecords * src_stride;
+    size_t dst_bytes = nrecords * dst_stride;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dst_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dst_bytes);
+    bitcpy_plan* plan = bitcpy_plan_compile(fields, n, src_stride, dst_stride);
+    if (!src || !dest || !expect || !plan) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        bitcpy_plan_free(plan);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dst_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    for (size_t r = 0; r < nrecords; r++) {
+        for (size_t i = 0; i < n; i++) {
+            uint64_t so = r * src_stride * 8 + fields[i].src_off;
+            uint64_t d_o = r * dst_stride * 8 + fields[i].dst_off;
+            bitcpy(expect + (d_o >> 3), d_o & 7, src + (so >> 3), so & 7, fields[i].len);
+        }
+    }
+    
+    // 按记录区间分两次执行，与多线程分段执行时每段的读写范围相同
+    size_t split = (size_t)rand() % (nrecords + 1);
+    bitcpy_plan_apply(plan, dest, src, split);
+    bitcpy_plan_apply(plan, dest + split * dst_stride, src + split * src_stride, nrecords - split);
+    int success = memcmp(dest, expect, dst_bytes) == 0;
+    
+    if (!success || verbose) {
+        printf("Test #%d: %llu fields, strides %llu/%llu bytes, %llu records -> %s\n", test_id,
+               (unsigned long long)n, (unsigned long long)src_stride,
+               (unsigned long long)dst_stride, (unsigned long long)nrecords,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    bitcpy_plan_free(plan);
+    return success;
+}
+
+// 单次随机带填充拷贝测试：源和目标都只在区间之后多分配 BITCPY_PAD_BYTES 字节（ASan 可检查越界），
+// 与逐位构造的期望结果对比整个缓冲区，包括填充字节
+int run_random_padded_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t src_bit = rand() % 8;
+    uint8_t dest_bit = rand() % 8;
+    uint64_t len = 1 + (uint64_t)rand() % max_len;
+    size_t src_bytes = (src_bit + len + 7) / 8 + BITCPY_PAD_BYTES;
+    size_t dest_bytes = (dest_bit + len + 7) / 8 + BITCPY_PAD_BYTES;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    uint8_t* expect = (uint8_t*)malloc(dest_bytes);
+    if (!src || !dest || !expect) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        free(expect);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    for (size_t i = 0; i < dest_bytes; i++) {
+        dest[i] = rand() & 0xFF;
+        expect[i] = dest[i];
+    }
+    for (uint64_t i = 0; i < len; i++) {
+        set_bit(expect, dest_bit + i, get_bit(src, src_bit + i));
+    }
+    
+    bitcpy_padded(dest, dest_bit, src, src_bit, len);
+    int success = memcmp(dest, expect, dest_bytes) == 0;
+    
+    if (!success || verbose) {
+        printf("Test #%d: src_bit=%d, dest_bit=%d, len=%llu -> %s\n",
+               test_id, src_bit, dest_bit, (unsigned long long)len,
+               success ? "PASS" : "FAIL");
+    }
+    
+    free(src);
+    free(dest);
+    free(expect);
+    return success;
+}
+
+// 单次随机统计测试：计数器清零后执行一次 bitcpy()，检查调用数、直方图、快速路径和各阶段位数之和；
+// 未定义 BITCPY_STATS 编译时快照应全部为 0
+int run_random_stats_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    uint8_t src_bit = rand() % 8;
+    uint8_t dest_bit = rand() % 8;
+    uint64_t len = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    if (rand() % 4 == 0) {
+        // 覆盖快速路径
+        src_bit = dest_bit = 0;
+        len = (len + 7) & ~(uint64_t)7;
+    }
+    size_t src_bytes = (src_bit + len + 7) / 8;
+    size_t dest_bytes = (dest_bit + len + 7) / 8;
+    
+    uint8_t* src = (uint8_t*)malloc(src_bytes);
+    uint8_t* dest = (uint8_t*)malloc(dest_bytes);
+    if (!src || !dest) {
+        printf("Memory allocation failed\n");
+        free(src);
+        free(dest);
+        return 0;
+    }
+    for (size_t i = 0; i < src_bytes; i++) {
+        src[i] = rand() & 0xFF;
+    }
+    memset(dest, 0, dest_bytes);
+    
+    bitcpy_stats_reset();
+    bitcpy(dest, dest_bit, src, src_bit, len);
+    bitcpy_stats st;
+    int enabled = bitcpy_stats_snapshot(&st);
+    
+    int success = 1;
+    if (!enabled) {
+        bitcpy_stats zero;
+        memset(&zero, 0, sizeof(zero));
+        success = memcmp(&st, &zero, sizeof(st)) == 0;
+    } else {
+        unsigned bucket = 0;
+        while ((len >> bucket) > 1) bucket++;
+        uint64_t hist_sum = 0;
+        for (int i = 0; i < BITCPY_STATS_LEN_BUCKETS; i++) {
+            hist_sum += st.len_hist[i];
+        }
+        int fast = (src_bit | dest_bit) == 0 && (len & 7) == 0;
+        uint64_t phase_bits = st.fast_path_bits + st.phase1_bits + st.simd_bits +
+                              64 * st.block64 + 8 * st.byte_iters + st.tail_bits;
+        success = st.calls == 1 && st.bits == len &&
+                  hist_sum == 1 && st.len_hist[bucket] == 1 &&
+                  st.offset_hist[src_bit][dest_bit] == 1 &&
+                  st.fast_path == (uint64_t)fast && phase_bits == len &&
+                  st.phase1 == (uint64_t)(!fast && dest_bit != 0) &&
+                  st.tail == (st.tail_bits != 0);
+    }
+    
+    if (verbose || !success) {
+        printf("Test #%d: src_bit=%u, dest_bit=%u, len=%llu, stats %s\n",
+               test_id, src_bit, dest_bit, (unsigned long long)len,
+               enabled ? "enabled" : "disabled");
+        printf("  calls=%llu bits=%llu fast=%llu phase1=%llu simd_bits=%llu block64=%llu "
+               "break=%llu bytes=%llu tail_bits=%llu\n",
+               (unsigned long long)st.calls, (unsigned long long)st.bits,
+               (unsigned long long)st.fast_path, (unsigned long long)st.phase1,
+               (unsigned long long)st.simd_bits, (unsigned long long)st.block64,
+               (unsigned long long)st.block64_break, (unsigned long long)st.byte_iters,
+               (unsigned long long)st.tail_bits);
+    }
+    
+    free(src);
+    free(dest);
+    return success;
+}
+
+// 与 bitcpy_trace_stop() 并发的调用线程：一直调用 bitcpy() 直到 stop 置位
+static void* trace_stop_worker(void* p) {
+    int* stop = (int*)p;
+    uint8_t src[16] = {0}, dest[16];
+    while (!__atomic_load_n(stop, __ATOMIC_ACQUIRE)) {
+        bitcpy(dest, 3, src, 5, 77);
+    }
+    return NULL;
+}
+
+// 结束记录时另一个线程仍在调用 bitcpy()（BITCPY_TRACE_FILE 在进程退出时的情形）：
+// 文件只能是完整的记录序列，每条记录都是该线程的调用
+static int check_trace_concurrent_stop(void) {
+    const char* path = "check_trace.tmp";
+    if (bitcpy_trace_start(path) != 0) return 1;  // 未定义 BITCPY_TRACE
+    int stop = 0;
+    pthread_t t;
+    if (pthread_create(&t, NULL, trace_stop_worker, &stop) != 0) {
+        bitcpy_trace_stop();
+        remove(path);
+        return 0;
+    }
+    struct timespec ts = {0, 2000000};
+    nanosleep(&ts, NULL);
+    int success = bitcpy_trace_stop() == 0;
+    nanosleep(&ts, NULL);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+    pthread_join(t, NULL);
+    
+    FILE* f = fopen(path, "rb");
+    char magic[8];
+    uint64_t rec;
+    if (!f || fread(magic, 1, 8, f) != 8 || memcmp(magic, BITCPY_TRACE_MAGIC, 8) != 0) {
+        success = 0;
+    }
+    while (success && f && fread(&rec, sizeof(rec), 1, f) == 1) {
+        bitcpy_trace_call c;
+        bitcpy_trace_decode(rec, &c);
+        success = c.len == 77 && c.dest_bit == 3 && c.src_bit == 5;
+    }
+    if (f) {
+        success = success && !ferror(f);
+        fclose(f);
+    }
+    remove(path);
+    return success;
+}
+
+// 第一次调用 bitcpy() 之前已经开始记录时，BITCPY_TRACE_FILE 不应结束调用者的记录、另开文件；
+// 必须在进程中第一次调用 bitcpy() 之前运行
+int run_trace_env_test(int* total) {
+    const char* path = "check_trace.tmp";
+    const char* env_path = "check_trace_env.tmp";
+    printf("Running BITCPY_TRACE_FILE test after explicit bitcpy_trace_start()...\n\n");
+    (*total)++;
+    
+    remove(env_path);
+    setenv("BITCPY_TRACE_FILE", env_path, 1);
+    int tracing = bitcpy_trace_start(path) == 0;
+    uint8_t src[8] = {0}, dest[8];
+    bitcpy(dest, 1, src, 2, 33);
+    bitcpy(dest, 4, src, 0, 12);
+    int success = bitcpy_trace_stop() == 0;
+    unsetenv("BITCPY_TRACE_FILE");
+    
+    FILE* env_file = fopen(env_path, "rb");
+    if (env_file) {
+        success = 0;
+        fclose(env_file);
+        remove(env_path);
+    }
+    if (tracing) {
+        FILE* f = fopen(path, "rb");
+        char magic[8];
+        uint64_t records[3];
+        size_t n = 0;
+        if (!f || fread(magic, 1, 8, f) != 8 || memcmp(magic, BITCPY_TRACE_MAGIC, 8) != 0) {
+            success = 0;
+        } else {
+            n = fread(records, sizeof(uint64_t), 3, f);
+        }
+        if (f) fclose(f);
+        remove(path);
+        success = success && n == 2;
+    }
+    
+    if (!success) {
+        printf("BITCPY_TRACE_FILE with explicit trace (tracing %s) -> FAIL\n",
+               tracing ? "enabled" : "disabled");
+    }
+    return !success;
+}
+
+static int same_trace_call(const bitcpy_trace_call* a, const bitcpy_trace_call* b) {
+    return a->len == b->len && a->dest_bit == b->dest_bit && a->src_bit == b->src_bit &&
+           a->dest_align == b->dest_align && a->src_align == b->src_align;
+}
+
+// 单次随机调用记录测试：记录格式的编码/解码往返；编译时定义 BITCPY_TRACE 时，
+// 再记录一串随机 bitcpy() 调用，读回文件逐条对比参数和指针对齐
+int run_random_trace_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    enum { CALLS = 50 };
+    static uint8_t src[4096 + 64], dest[4096 + 64];
+    bitcpy_trace_call calls[CALLS];
+    for (int i = 0; i < CALLS; i++) {
+        calls[i].len = (uint64_t)rand() % (max_len + 1);
+        calls[i].dest_bit = rand() % 8;
+        calls[i].src_bit = rand() % 8;
+        calls[i].dest_align = rand() % 64;
+        calls[i].src_align = rand() % 64;
+    }
+    
+    int success = 1;
+    for (int i = 0; i < CALLS && success; i++) {
+        bitcpy_trace_call c;
+        bitcpy_trace_decode(bitcpy_trace_encode(&calls[i]), &c);
+        success = same_trace_call(&c, &calls[i]);
+    }
+    
+    if (test_id == 1 && success) {
+        success = check_trace_concurrent_stop();
+    }
+    
+    const char* path = "check_trace.tmp";
+    int tracing = success && bitcpy_trace_start(path) == 0;
+    if (tracing) {
+        for (int i = 0; i < CALLS; i++) {
+            // 按记录的对齐选择指针：缓冲区起点之后第一个地址 mod 64 等于该值的字节
+            uint8_t* d = dest + ((calls[i].dest_align - (uintptr_t)dest) & 63);
+            const uint8_t* sp = src + ((calls[i].src_align - (uintptr_t)src) & 63);
+            bitcpy(d, calls[i].dest_bit, sp, calls[i].src_bit, calls[i].len);
+        }
+        success = bitcpy_trace_stop() == 0;
+        
+        FILE* f = fopen(path, "rb");
+        char magic[8];
+        uint64_t records[CALLS + 1];
+        size_t n = 0;
+        if (!f || fread(magic, 1, 8, f) != 8 || memcmp(magic, BITCPY_TRACE_MAGIC, 8) != 0) {
+            success = 0;
+        } else {
+            n = fread(records, sizeof(uint64_t), CALLS + 1, f);
+        }
+        if (f) fclose(f);
+        remove(path);
+        success = success && n == CALLS;
+        for (size_t i = 0; i < n && success; i++) {
+            bitcpy_trace_call c;
+            bitcpy_trace_decode(records[i], &c);
+            success = same_trace_call(&c, &calls[i]);
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Test #%d: %d calls, tracing %s -> %s\n", test_id, CALLS,
+               tracing ? "enabled" : "disabled", success ? "PASS" : "FAIL");
+    }
+    return success;
+}
+
+// 异步队列压力测试：多个线程并发提交，每个任务使用独立的缓冲区，队列容量小于在途任务数，
+// 覆盖提交失败重试、槽复用、大任务切块窃取以及 bitcpy_poll()/bitcpy_wait() 两种等待方式
+#define ASYNC_TEST_THREADS 4
+#define ASYNC_TEST_JOBS 8
+
+static bitcpy_queue* check_queue = NULL;
+
+typedef struct {
+    unsigned int seed;
+    uint64_t max_len;
+    int success;
+} async_test_arg;
+
+static void* async_submitter(void* p) {
+    async_test_arg* a = (async_test_arg*)p;
+    unsigned int seed = a->seed;
+    uint8_t* src[ASYNC_TEST_JOBS] = {0};
+    uint8_t* dest[ASYNC_TEST_JOBS] = {0};
+    uint8_t* expect[ASYNC_TEST_JOBS] = {0};
+    size_t dest_bytes[ASYNC_TEST_JOBS];
+    bitcpy_handle h[ASYNC_TEST_JOBS] = {0};
+    a->success = 1;
+    
+    for (int i = 0; i < ASYNC_TEST_JOBS; i++) {
+        // 四分之一的任务足够长，会被切块并由多个工作线程执行
+        uint64_t max_len = rand_r(&seed) % 4 == 0 ? a->max_len : 4096;
+        bitcpy_desc d;
+        d.src_bit = rand_r(&seed) % 8;
+        d.dest_bit = rand_r(&seed) % 8;
+        d.len = 1 + ((uint64_t)rand_r(&seed) * RAND_MAX + rand_r(&seed)) % max_len;
+        size_t src_bytes = (d.src_bit + d.len + 7) / 8;
+        dest_bytes[i] = (d.dest_bit + d.len + 7) / 8;
+        src[i] = (uint8_t*)malloc(src_bytes);
+        dest[i] = (uint8_t*)malloc(dest_bytes[i]);
+        expect[i] = (uint8_t*)malloc(dest_bytes[i]);
+        if (!src[i] || !dest[i] || !expect[i]) {
+            a->success = 0;
+            break;
+        }
+        for (size_t j = 0; j < src_bytes; j++) {
+            src[i][j] = rand_r(&seed) & 0xFF;
+        }
+        for (size_t j = 0; j < dest_bytes[i]; j++) {
+            dest[i][j] = rand_r(&seed) & 0xFF;
+        }
+        memcpy(expect[i], dest[i], dest_bytes[i]);
+        bitcpy(expect[i], d.dest_bit, src[i], d.src_bit, d.len);
         
-        if (run_random_test(i, test_seed, 0)) {
-            passed++;
+        d.src = src[i];
+        d.dest = dest[i];
+        while ((h[i] = bitcpy_submit(check_queue, &d)) == 0) {
+            // 在途任务已满：等待本线程之前的任务后重试
+            if (i > 0) bitcpy_wait(check_queue, h[i - 1]);
+        }
+    }
+    
+    for (int i = 0; i < ASYNC_TEST_JOBS; i++) {
+        if (h[i] == 0) continue;
+        if (rand_r(&seed) % 2) {
+            while (!bitcpy_poll(check_queue, h[i])) {
+            }
         } else {
+            bitcpy_wait(check_queue, h[i]);
+        }
+        if (memcmp(dest[i], expect[i], dest_bytes[i]) != 0) a->success = 0;
+    }
+    for (int i = 0; i < ASYNC_TEST_JOBS; i++) {
+        free(src[i]);
+        free(dest[i]);
+        free(expect[i]);
+    }
+    return NULL;
+}
+
+int run_random_async_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    async_test_arg args[ASYNC_TEST_THREADS];
+    pthread_t threads[ASYNC_TEST_THREADS];
+    int started = 0;
+    int success = 1;
+    for (int t = 0; t < ASYNC_TEST_THREADS; t++) {
+        args[t].seed = seed * ASYNC_TEST_THREADS + t;
+        args[t].max_len = max_len;
+        if (pthread_create(&threads[t], NULL, async_submitter, &args[t]) != 0) {
+            success = 0;
+            break;
+        }
+        started++;
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        success = success && args[t].success;
+    }
+    
+    // 所有任务都已等待完成，完成计数必须追上提交计数
+    bitcpy_queue_stats st;
+    bitcpy_queue_get_stats(check_queue, &st);
+    success = success && st.completed == st.submitted;
+    
+    if (!success || verbose) {
+        printf("Test #%d: %d threads x %d jobs, %llu submitted, %llu rejected -> %s\n", test_id,
+               ASYNC_TEST_THREADS, ASYNC_TEST_JOBS, (unsigned long long)st.submitted,
+               (unsigned long long)st.rejected, success ? "PASS" : "FAIL");
+    }
+    return success;
+}
+
+// 位环形缓冲区测试：生产者线程把源位数组按随机长度的记录依次写入，消费者线程按不超过可读位数的
+// 随机长度读出并顺序拼接；缓冲区只有几十字节，覆盖回绕、缓冲区满/空的重试和首尾不完整的字节
+typedef struct {
+    bitring* ring;
+    const uint8_t* src;
+    uint64_t total;
+    unsigned int seed;
+} ring_test_arg;
+
+static void* ring_producer(void* p) {
+    ring_test_arg* a = (ring_test_arg*)p;
+    unsigned int seed = a->seed;
+    uint64_t max_rec = a->ring->cap;
+    uint64_t pos = 0;
+    while (pos < a->total) {
+        uint64_t n = 1 + rand_r(&seed) % max_rec;
+        if (n > a->total - pos) n = a->total - pos;
+        while (!bitring_push(a->ring, a->src + (pos >> 3), pos & 7, n)) {
+            sched_yield();
+        }
+        pos += n;
+    }
+    return NULL;
+}
+
+int run_random_ring_test(int test_id, unsigned int seed, uint64_t max_len, int verbose) {
+    srand(seed);
+    
+    if (test_id == 1) {
+        // 容量为 0：len == 0 立即成功，len > 0 失败，都不访问缓冲区
+        bitring zero_ring;
+        uint8_t bits = 0xA5;
+        bitring_init(&zero_ring, NULL, 0);
+        int success = bitring_push(&zero_ring, &bits, 0, 0) == 1 &&
+                      bitring_pop(&zero_ring, &bits, 0, 0) == 1 &&
+                      bitring_push(&zero_ring, &bits, 0, 1) == 0 &&
+                      bitring_pop(&zero_ring, &bits, 0, 1) == 0 && bits == 0xA5;
+        if (!success || verbose) {
+            printf("Test #%d: ring 0 bytes -> %s\n", test_id, success ? "PASS" : "FAIL");
+        }
+        if (!success) return 0;
+    }
+    
+    size_t ring_bytes = 1 + rand() % 64;
+    uint64_t total = 1 + ((uint64_t)rand() * RAND_MAX + rand()) % max_len;
+    size_t total_bytes = (total + 7) / 8;
+    uint8_t* ring_buf = (uint8_t*)malloc(ring_bytes);
+    uint8_t* src = (uint8_t*)malloc(total_bytes);
+    uint8_t* dest = (uint8_t*)malloc(total_bytes);
+    if (!ring_buf || !src || !dest) {
+        printf("Memory allocation failed\n");
+        free(ring_buf);
+        free(src);
+        free(dest);
+        return 0;
+    }
+    for (size_t i = 0; i < total_bytes; i++) {
+        src[i] = rand() & 0xFF;
+        dest[i] = rand() & 0xFF;
+    }
+    
+    bitring ring;
+    bitring_init(&ring, ring_buf, ring_bytes);
+    ring_test_arg arg = {&ring, src, total, seed};
+    pthread_t producer;
+    int success = pthread_create(&producer, NULL, ring_producer, &arg) == 0;
+    if (success) {
+        uint64_t pos = 0;
+        while (pos < total) {
+            // 读出长度不超过当前可读位数，否则与等待空间的生产者互相等待
+            uint64_t avail = bitring_readable(&ring);
+            if (avail == 0) {
+                sched_yield();
+                continue;
+            }
+            uint64_t n = 1 + rand() % avail;
+            success = bitring_pop(&ring, dest + (pos >> 3), pos & 7, n) && success;
+            pos += n;
+        }
+        pthread_join(producer, NULL);
+        success = success && bitring_readable(&ring) == 0;
+        for (uint64_t i = 0; i < total && success; i++) {
+            success = get_bit(dest, i) == get_bit(src, i);
+        }
+    }
+    
+    if (!success || verbose) {
+        printf("Test #%d: ring %llu bytes, %llu bits -> %s\n", test_id,
+               (unsigned long long)ring_bytes, (unsigned long long)total,
+               success ? "PASS" : "FAIL");
+    }
+    free(ring_buf);
+    free(src);
+    free(dest);
+    return success;
+}
+
+// 运行一组随机测试，返回失败数
+typedef int (*random_test_fn)(int test_id, unsigned int seed, uint64_t max_len, int verbose);
+
+// seed 为本组的基础种子，返回时前进 num_tests，使各组的种子互不重叠；total 累加测试数
+int run_random_suite(const char* name, random_test_fn test, int num_tests,
+                     uint64_t max_len, unsigned int* seed, int* total) {
+    int failed = 0;
+    unsigned int base_seed = *seed;
+    *seed += num_tests;
+    *total += num_tests;
+    
+    printf("Running %d random %s tests (len 1-%llu, seed=%u)...\n",
+           num_tests, name, (unsigned long long)max_len, base_seed);
+    
+    for (int i = 1; i <= num_tests; i++) {
+        unsigned int test_seed = base_seed + i;
+        
+        if (!test(i, test_seed, max_len, 0)) {
             failed++;
             // 失败时重新运行一次并显示详细信息
             printf("Reproducing failed test #%d with details (seed=%u):\n", i, test_seed);
-            run_random_test(i, test_seed, 1);
+            test(i, test_seed, max_len, 1);
         }
         
         // 进度显示
         if (i % 1000 == 0) {
-            printf("Progress: %d/%d tests completed\n", i, NUM_TESTS);
+            printf("Progress: %d/%d tests completed\n", i, num_tests);
         }
     }
+    printf("\n");
+    return failed;
+}
+
+int main() {
+    int total = 0;
+    int failed = 0;
+    
+    // 使用时间作为基础种子
+    unsigned int base_seed = (unsigned int)time(NULL);
+    unsigned int seed = base_seed;
+    
+    // 调用记录与环境变量：必须在第一次调用 bitcpy() 之前
+    failed += run_trace_env_test(&total);
+    // 短拷贝：覆盖快速路径和阶段1-4的各种组合
+    failed += run_random_suite("bitcpy", run_random_test, 10000, 200, &seed, &total);
+    // 长拷贝：覆盖阶段2的 SIMD 内核及其与标量循环的衔接
+    failed += run_random_suite("large bitcpy", run_random_test, 2000, 8192, &seed, &total);
+    // MSB 优先位序：短拷贝覆盖阶段1-4，长拷贝覆盖 SIMD 内核
+    failed += run_random_suite("bitcpy_msb", run_random_msb_test, 10000, 200, &seed, &total);
+    failed += run_random_suite("large bitcpy_msb", run_random_msb_test, 2000, 8192, &seed, &total);
+    // 带填充拷贝：覆盖单字、首尾字和中间整字，以及超过阈值时交给 bitcpy()
+    failed += run_random_suite("bitcpy_padded", run_random_padded_test, 10000, 1200, &seed, &total);
+    // 重叠移动：覆盖 bitmove 的正向与反向路径
+    failed += run_random_suite("bitmove", run_random_move_test, 10000, 1024, &seed, &total);
+    // 插入/删除：覆盖尾部的反向和正向移动，以及插入数据和插入 0
+    failed += run_random_suite("bitinsert/bitdelete", run_random_splice_test, 4000, 4096,
+                               &seed, &total);
+    // 批量拷贝：覆盖短拷贝内核、长拷贝回退和窗口边界
+    failed += run_random_suite("bitcpy_batch", run_random_batch_test, 200, 600, &seed, &total);
+    // 并行拷贝：阈值设为 0，使每次调用都切块，覆盖块边界和首尾块
+    bitcpy_parallel_init(4);
+    bitcpy_parallel_set_threshold(0);
+    failed += run_random_suite("bitcpy_parallel", run_random_parallel_test, 500, 1 << 20,
+                               &seed, &total);
+    bitcpy_parallel_shutdown();
+    // 流式拷贝：覆盖首部对齐、非临时存储主体和尾部
+    failed += run_random_suite("bitcpy_stream", run_random_stream_test, 2000, 1 << 16,
+                               &seed, &total);
+    // 文件拷贝：窗口设为一页，使每次拷贝跨越多个窗口边界
+    bitcpy_file_set_window(1);
+    failed += run_random_suite("bitcpy_file", run_random_file_test, 300, 1 << 17, &seed, &total);
+    bitcpy_file_set_window(0);
+    // 文件拷贝的 pread/pwrite 回退路径：缓冲区 100 字节，覆盖窗口首尾不完整字节的读出合并
+    bitcpy_file_set_stream(100);
+    failed += run_random_suite("bitcpy_file stream", run_random_file_test, 300, 1 << 17,
+                               &seed, &total);
+    bitcpy_file_set_stream(0);
+    // 异步队列：4 个工作线程，容量 16 小于并发提交的任务数
+    check_queue = bitcpy_queue_create(4, 16);
+    if (check_queue != NULL) {
+        failed += run_random_suite("bitcpy_async", run_random_async_test, 200, 1 << 22,
+                                   &seed, &total);
+        bitcpy_queue_destroy(check_queue);
+    } else {
+        printf("bitcpy_queue_create failed\n");
+        failed++;
+        total++;
+    }
+    // 位环形缓冲区：生产者和消费者分别在两个线程
+    failed += run_random_suite("bitring", run_random_ring_test, 500, 1 << 16, &seed, &total);
+    // 位流读写游标
+    failed += run_random_suite("bitstream", run_random_bitstream_test, 2000, 20000,
+                               &seed, &total);
+    // 位打包/解包：覆盖 SIMD 整组、组间进位和标量尾部
+    failed += run_random_suite("bitpack", run_random_bitpack_test, 4000, 1000, &seed, &total);
+    // 位与字节数组的展开/压缩：覆盖首尾不完整字节和向量内核
+    failed += run_random_suite("bits_to_bytes/bytes_to_bits", run_random_expand_test, 4000, 4096,
+                               &seed, &total);
+    // 布局转换计划：覆盖字段合并、切片与目标字分组、长段 bitcpy() 和末尾记录的回退
+    failed += run_random_suite("bitcpy_plan", run_random_plan_test, 4000, 600, &seed, &total);
+    // 位区间逻辑运算：覆盖两个操作数位偏移不同、原地运算和 SIMD 内核
+    failed += run_random_suite("bitop", run_random_bitop_test, 4000, 4096, &seed, &total);
+    // 二维位块传送：覆盖五种光栅运算、首尾掩码、窄行和 SIMD 行体
+    failed += run_random_suite("bitblit", run_random_blit_test, 4000, 2048, &seed, &total);
+    // 位区间计数与查找：覆盖首尾掩码、向量内核和未找到的情况
+    failed += run_random_suite("bitscan", run_random_scan_test, 4000, 1 << 14, &seed, &total);
+    // 位区间比较：覆盖相同、区间内一位不同和区间外的位不同
+    failed += run_random_suite("bitcmp", run_random_cmp_test, 4000, 1 << 14, &seed, &total);
+    // 位填充：短区间覆盖首尾掩码，长区间覆盖非临时存储
+    failed += run_random_suite("bitfill", run_random_fill_test, 4000, 4096, &seed, &total);
+    failed += run_random_suite("large bitfill", run_random_fill_test, 20, 1 << 26, &seed, &total);
+    // 热路径统计：未定义 BITCPY_STATS 时只检查快照为 0
+    failed += run_random_suite("bitcpy stats", run_random_stats_test, 2000, 4096, &seed, &total);
+    // 调用记录：未定义 BITCPY_TRACE 时只检查记录格式的编码/解码
+    failed += run_random_suite("bitcpy trace", run_random_trace_test, 200, 4096, &seed, &total);
+    // 内联特化：bitcpy_fixed 穷举和常量参数的 BITCPY_INLINE
+    failed += run_fixed_tests(base_seed, &total);
     
-    printf("\n=== Test Results ===\n");
-    printf("Total:  %d\n", NUM_TESTS);
+    int passed = total - failed;
+    printf("=== Test Results ===\n");
+    printf("Total:  %d\n", total);
     printf("Passed: %d\n", passed);
     printf("Failed: %d\n", failed);
-    printf("Success rate: %.2f%%\n", (passed * 100.0) / NUM_TESTS);
+    printf("Success rate: %.2f%%\n", (passed * 100.0) / total);
     
     return failed == 0 ? 0 : 1;
 }
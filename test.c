@@ -3,6 +3,14 @@
 #include <string.h>
 #include <time.h>
 #include "bitcpy.h"
+#include "bitcpy_inline.h"
+#include "bitstream.h"
+#include "bitpack.h"
+#include "bitop.h"
+#include "bitscan.h"
+#include "bitring.h"
+#include <pthread.h>
+#include <sched.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -108,18 +116,19 @@ void init_samples(void) {
         tc->src_bytes = (tc->src_bit + tc->len + 7) / 8;
         tc->dest_bytes = (tc->dest_bit + tc->len + 7) / 8;
         
-        // 分配紧凑格式缓冲区
-        tc->src = (uint8_t*)malloc(tc->src_bytes);
-        tc->dest = (uint8_t*)malloc(tc->dest_bytes);
+        // 分配紧凑格式缓冲区（末尾留出 bitcpy_padded 需要的填充）
+        tc->src = (uint8_t*)malloc(tc->src_bytes + BITCPY_PAD_BYTES);
+        tc->dest = (uint8_t*)malloc(tc->dest_bytes + BITCPY_PAD_BYTES);
         
         // 分配展开格式缓冲区（1字节=1位）
         tc->src_expanded = (uint8_t*)malloc(tc->src_bit + tc->len);
         tc->dest_expanded = (uint8_t*)malloc(tc->dest_bit + tc->len);
         
         // 随机填充源数据
-        for (size_t j = 0; j < tc->src_bytes; j++) {
+        for (size_t j = 0; j < tc->src_bytes + BITCPY_PAD_BYTES; j++) {
             tc->src[j] = rand() & 0xFF;
         }
+        memset(tc->dest, 0, tc->dest_bytes + BITCPY_PAD_BYTES);
         
         // 展开源数据
         expand_bits(tc->src, tc->src_bit, tc->src_expanded, tc->len);
@@ -151,6 +160,43 @@ double benchmark_bitcpy(void) {
     return end - start;
 }
 
+// 运行 bitcpy_padded 性能测试（与 benchmark_bitcpy 相同的样例，缓冲区带填充）
+double benchmark_bitcpy_padded(void) {
+    double start = get_time_ms();
+    
+    for (int iter = 0; iter < NUM_ITERATIONS; iter++) {
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            TestCase* tc = &samples[i];
+            bitcpy_padded(tc->dest, tc->dest_bit, tc->src, tc->src_bit, tc->len);
+        }
+    }
+    
+    double end = get_time_ms();
+    return end - start;
+}
+
+// 运行 bitcpy_batch 性能测试（与 benchmark_bitcpy 相同的样例，一次提交全部描述符）
+double benchmark_bitcpy_batch(void) {
+    static bitcpy_desc descs[NUM_SAMPLES];
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        TestCase* tc = &samples[i];
+        descs[i].dest = tc->dest;
+        descs[i].src = tc->src;
+        descs[i].len = tc->len;
+        descs[i].dest_bit = tc->dest_bit;
+        descs[i].src_bit = tc->src_bit;
+    }
+    
+    double start = get_time_ms();
+    
+    for (int iter = 0; iter < NUM_ITERATIONS; iter++) {
+        bitcpy_batch(descs, NUM_SAMPLES);
+    }
+    
+    double end = get_time_ms();
+    return end - start;
+}
+
 // 运行 bitwise 性能测试（真正逐位拷贝）
 double benchmark_bitwise(void) {
     double start = get_time_ms();
@@ -182,6 +228,572 @@ double benchmark_expanded(void) {
     return end - start;
 }
 
+typedef void (*copy_fn)(uint8_t* dest, uint8_t dest_bit,
+                        const uint8_t* src, uint8_t src_bit, uint64_t len);
+
+// 大块非对齐拷贝性能测试（阶段2 SIMD 内核），返回 GB/s
+#define LARGE_BYTES (16u << 20)
+#define LARGE_ITERATIONS 20
+
+double benchmark_bitcpy_large(copy_fn copy, uint8_t src_bit, uint8_t dest_bit) {
+    uint8_t* src = (uint8_t*)malloc(LARGE_BYTES + 1);
+    uint8_t* dest = (uint8_t*)malloc(LARGE_BYTES + 1);
+    uint64_t len = (uint64_t)LARGE_BYTES * 8;
+    if (!src || !dest) {
+        free(src);
+        free(dest);
+        return 0.0;
+    }
+    for (size_t i = 0; i < LARGE_BYTES + 1; i++) {
+        src[i] = (uint8_t)rand();
+        dest[i] = 0;
+    }
+    
+    copy(dest, dest_bit, src, src_bit, len);  // 预热
+    double start = get_time_ms();
+    for (int iter = 0; iter < LARGE_ITERATIONS; iter++) {
+        copy(dest, dest_bit, src, src_bit, len);
+    }
+    double elapsed = get_time_ms() - start;
+    
+    free(src);
+    free(dest);
+    return (double)LARGE_BYTES * LARGE_ITERATIONS / (elapsed / 1000.0) / 1e9;
+}
+
+// 非对齐位区间 AND：先 bitcpy() 两个操作数到对齐的临时缓冲区再逐字运算、拷回，对比 bitop()，返回 ms
+#define BITOP_BYTES (4u << 20)
+#define BITOP_ITERATIONS 20
+
+double benchmark_bitop(int use_bitop) {
+    uint8_t* a = (uint8_t*)malloc(BITOP_BYTES + 1);
+    uint8_t* b = (uint8_t*)malloc(BITOP_BYTES + 1);
+    uint8_t* dest = (uint8_t*)malloc(BITOP_BYTES + 1);
+    uint64_t* ta = (uint64_t*)malloc(BITOP_BYTES);
+    uint64_t* tb = (uint64_t*)malloc(BITOP_BYTES);
+    uint64_t len = (uint64_t)BITOP_BYTES * 8 - 64;
+    double elapsed = 0.0;
+    if (a && b && dest && ta && tb) {
+        for (size_t i = 0; i < BITOP_BYTES + 1; i++) {
+            a[i] = (uint8_t)rand();
+            b[i] = (uint8_t)rand();
+            dest[i] = 0;
+        }
+        double start = get_time_ms();
+        for (int iter = 0; iter < BITOP_ITERATIONS; iter++) {
+            if (use_bitop) {
+                bitop(dest, 1, a, 3, b, 6, len, BITOP_AND);
+            } else {
+                bitcpy((uint8_t*)ta, 0, a, 3, len);
+                bitcpy((uint8_t*)tb, 0, b, 6, len);
+                for (size_t i = 0; i < BITOP_BYTES / 8; i++) {
+                    ta[i] &= tb[i];
+                }
+                bitcpy(dest, 1, (const uint8_t*)ta, 0, len);
+            }
+        }
+        elapsed = get_time_ms() - start;
+    }
+    free(a);
+    free(b);
+    free(dest);
+    free(ta);
+    free(tb);
+    return elapsed;
+}
+
+// 位区间计数与查找：逐位循环对比 bitcount/bitfind_set，返回 ms
+#define SCAN_BYTES (1u << 20)
+#define SCAN_ITERATIONS 20
+
+static uint8_t* scan_buf;
+static volatile uint64_t scan_sink;
+
+static uint64_t count_bitwise(const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < len; i++) {
+        uint64_t pos = src_bit + i;
+        count += (src[pos >> 3] >> (pos & 7)) & 1;
+    }
+    return count;
+}
+
+static uint64_t find_set_bitwise(const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    for (uint64_t i = 0; i < len; i++) {
+        uint64_t pos = src_bit + i;
+        if ((src[pos >> 3] >> (pos & 7)) & 1) return i;
+    }
+    return len;
+}
+
+// mode 0: 逐位计数，1: bitcount，2: 逐位查找，3: bitfind_set（唯一的 1 位于区间末尾附近）
+double benchmark_scan(int mode) {
+    uint64_t len = (uint64_t)SCAN_BYTES * 8 - 8;
+    double start = get_time_ms();
+    for (int iter = 0; iter < SCAN_ITERATIONS; iter++) {
+        switch (mode) {
+        case 0: scan_sink = count_bitwise(scan_buf, 5, len); break;
+        case 1: scan_sink = bitcount(scan_buf, 5, len); break;
+        case 2: scan_sink = find_set_bitwise(scan_buf, 5, len); break;
+        default: scan_sink = bitfind_set(scan_buf, 5, len); break;
+        }
+    }
+    return get_time_ms() - start;
+}
+
+// 位与字节数组的展开/压缩：test.c 原有的逐位 expand_bits/compact_bits 对比 bits_to_bytes/bytes_to_bits，
+// 位区间从第 3 位开始，返回 ms
+#define EXPAND_BITS (1u << 23)
+#define EXPAND_ITERATIONS 20
+
+double benchmark_expand(int mode, uint8_t* bits, uint8_t* bytes) {
+    uint64_t len = EXPAND_BITS - 8;
+    double start = get_time_ms();
+    for (int iter = 0; iter < EXPAND_ITERATIONS; iter++) {
+        switch (mode) {
+        case 0: expand_bits(bits, 3, bytes, len); break;
+        case 1: bits_to_bytes(bytes, bits, 3, len); break;
+        case 2: compact_bits(bytes, bits, 3, len); break;
+        default: bytes_to_bits(bits, 3, bytes, len); break;
+        }
+    }
+    return get_time_ms() - start;
+}
+
+// 在 4 MiB 位向量前部插入 13 位再删除：用临时缓冲区 bitcpy() 尾部两次对比原地的 bitinsert/bitdelete，返回 ms
+#define SPLICE_BYTES (4u << 20)
+#define SPLICE_ITERATIONS 20
+
+double benchmark_splice(int use_splice) {
+    uint8_t* buf = (uint8_t*)malloc(SPLICE_BYTES);
+    uint8_t* scratch = (uint8_t*)malloc(SPLICE_BYTES);
+    uint8_t field[2] = {0x5A, 0x1C};
+    uint64_t used = (uint64_t)SPLICE_BYTES * 8 - 64;
+    uint64_t pos = 1001, k = 13;
+    double elapsed = 0.0;
+    if (buf && scratch) {
+        for (size_t i = 0; i < SPLICE_BYTES; i++) {
+            buf[i] = (uint8_t)rand();
+        }
+        double start = get_time_ms();
+        for (int iter = 0; iter < SPLICE_ITERATIONS; iter++) {
+            if (use_splice) {
+                bitinsert(buf, used, pos, field, 0, k);
+                bitdelete(buf, used + k, pos, k);
+            } else {
+                uint64_t tail = used - pos;
+                bitcpy(scratch, 0, buf + (pos >> 3), pos & 7, tail);
+                bitcpy(buf + (pos >> 3), pos & 7, field, 0, k);
+                bitcpy(buf + ((pos + k) >> 3), (pos + k) & 7, scratch, 0, tail);
+                bitcpy(scratch, 0, buf + ((pos + k) >> 3), (pos + k) & 7, tail);
+                bitcpy(buf + (pos >> 3), pos & 7, scratch, 0, tail);
+            }
+        }
+        elapsed = get_time_ms() - start;
+    }
+    free(buf);
+    free(scratch);
+    return elapsed;
+}
+
+// 清空非对齐位区间：从预先分配的全 0 缓冲区 bitcpy() 对比 bitfill()，返回 GB/s
+double benchmark_fill(int use_bitfill) {
+    uint8_t* dest = (uint8_t*)malloc(LARGE_BYTES + 1);
+    uint8_t* zeros = use_bitfill ? NULL : (uint8_t*)calloc(LARGE_BYTES + 1, 1);
+    uint64_t len = (uint64_t)LARGE_BYTES * 8;
+    if (!dest || (!use_bitfill && !zeros)) {
+        free(dest);
+        free(zeros);
+        return 0.0;
+    }
+    memset(dest, 0xA5, LARGE_BYTES + 1);
+    
+    double start = get_time_ms();
+    for (int iter = 0; iter < LARGE_ITERATIONS; iter++) {
+        if (use_bitfill) {
+            bitfill(dest, 3, len, 0);
+        } else {
+            bitcpy(dest, 3, zeros, 0, len);
+        }
+    }
+    double elapsed = get_time_ms() - start;
+    
+    free(dest);
+    free(zeros);
+    return (double)LARGE_BYTES * LARGE_ITERATIONS / (elapsed / 1000.0) / 1e9;
+}
+
+// 非对齐位区间比较（两区间相同，需要比较到末尾）：bitcpy() 到对齐缓冲区再 memcmp 对比 bitequal()，返回 ms
+double benchmark_cmp(int use_bitequal) {
+    uint8_t* a = (uint8_t*)malloc(BITOP_BYTES + 1);
+    uint8_t* b = (uint8_t*)malloc(BITOP_BYTES + 1);
+    uint8_t* ta = (uint8_t*)malloc(BITOP_BYTES);
+    uint8_t* tb = (uint8_t*)malloc(BITOP_BYTES);
+    uint64_t len = (uint64_t)BITOP_BYTES * 8 - 64;
+    double elapsed = 0.0;
+    if (a && b && ta && tb) {
+        for (size_t i = 0; i < BITOP_BYTES + 1; i++) {
+            a[i] = (uint8_t)rand();
+        }
+        bitcpy(b, 6, a, 3, len);
+        int equal = 0;
+        double start = get_time_ms();
+        for (int iter = 0; iter < BITOP_ITERATIONS; iter++) {
+            if (use_bitequal) {
+                equal += bitequal(a, 3, b, 6, len);
+            } else {
+                bitcpy(ta, 0, a, 3, len);
+                bitcpy(tb, 0, b, 6, len);
+                equal += memcmp(ta, tb, (size_t)(len >> 3)) == 0;
+            }
+        }
+        elapsed = get_time_ms() - start;
+        scan_sink = (uint64_t)equal;
+    }
+    free(a);
+    free(b);
+    free(ta);
+    free(tb);
+    return elapsed;
+}
+
+// 流式拷贝对缓存驻留负载的影响：大块拷贝与一个常驻缓存的热数据遍历交替运行，
+// 分别统计拷贝带宽和每次拷贝之后遍历热数据的耗时
+#define STREAM_BYTES (64u << 20)
+#define HOT_BYTES (1u << 20)
+#define STREAM_ROUNDS 10
+
+static volatile uint64_t hot_sink;
+
+void benchmark_stream(copy_fn copy, double* copy_gbps, double* hot_ms) {
+    uint8_t* src = (uint8_t*)malloc(STREAM_BYTES + 1);
+    uint8_t* dest = (uint8_t*)malloc(STREAM_BYTES + 1);
+    uint64_t* hot = (uint64_t*)malloc(HOT_BYTES);
+    *copy_gbps = 0.0;
+    *hot_ms = 0.0;
+    if (!src || !dest || !hot) {
+        free(src);
+        free(dest);
+        free(hot);
+        return;
+    }
+    memset(src, 0x5A, STREAM_BYTES + 1);
+    memset(dest, 0, STREAM_BYTES + 1);
+    // 热数据是一条随机顺序的指针链，遍历时按延迟计费，不会被硬件预取掩盖缓存缺失
+    size_t hot_count = HOT_BYTES / 8;
+    for (size_t i = 0; i < hot_count; i++) {
+        hot[i] = i;
+    }
+    for (size_t i = hot_count - 1; i > 0; i--) {
+        size_t j = ((size_t)rand() * RAND_MAX + (size_t)rand()) % i;  // Sattolo：生成单个环
+        uint64_t t = hot[i];
+        hot[i] = hot[j];
+        hot[j] = t;
+    }
+    
+    double copy_time = 0.0;
+    double hot_time = 0.0;
+    for (int round = 0; round < STREAM_ROUNDS; round++) {
+        // 先让热数据进入缓存
+        uint64_t pos = 0;
+        for (size_t i = 0; i < hot_count; i++) pos = hot[pos];
+        
+        double t0 = get_time_ms();
+        copy(dest, 3, src, 5, (uint64_t)STREAM_BYTES * 8);
+        double t1 = get_time_ms();
+        for (size_t i = 0; i < hot_count; i++) pos = hot[pos];
+        double t2 = get_time_ms();
+        
+        hot_sink = pos;
+        copy_time += t1 - t0;
+        hot_time += t2 - t1;
+    }
+    
+    *copy_gbps = (double)STREAM_BYTES * STREAM_ROUNDS / (copy_time / 1000.0) / 1e9;
+    *hot_ms = hot_time / STREAM_ROUNDS;
+    free(src);
+    free(dest);
+    free(hot);
+}
+
+// 固定宽度字段拷贝：dest_bit/src_bit/len 都是编译期常量，对比 BITCPY_INLINE 与 bitcpy()
+#define FIELD_RECORDS 4096
+#define FIELD_STRIDE 8
+#define FIELD_ITERATIONS 2000
+
+static uint8_t field_src[FIELD_RECORDS * FIELD_STRIDE];
+static uint8_t field_dest[FIELD_RECORDS * FIELD_STRIDE];
+
+#define DEFINE_FIELD_BENCH(W, DB, SB)                                               \
+    static double benchmark_field_call_##W(void) {                                  \
+        double start = get_time_ms();                                               \
+        for (int iter = 0; iter < FIELD_ITERATIONS; iter++) {                       \
+            for (int i = 0; i < FIELD_RECORDS; i++) {                               \
+                bitcpy(field_dest + i * FIELD_STRIDE, DB,                           \
+                       field_src + i * FIELD_STRIDE, SB, W);                        \
+            }                                                                       \
+        }                                                                           \
+        return get_time_ms() - start;                                               \
+    }                                                                               \
+    static double benchmark_field_inline_##W(void) {                                \
+        double start = get_time_ms();                                               \
+        for (int iter = 0; iter < FIELD_ITERATIONS; iter++) {                       \
+            for (int i = 0; i < FIELD_RECORDS; i++) {                               \
+                BITCPY_INLINE(field_dest + i * FIELD_STRIDE, DB,                    \
+                              field_src + i * FIELD_STRIDE, SB, W);                 \
+            }                                                                       \
+        }                                                                           \
+        return get_time_ms() - start;                                               \
+    }
+
+DEFINE_FIELD_BENCH(3, 5, 2)
+DEFINE_FIELD_BENCH(12, 3, 7)
+DEFINE_FIELD_BENCH(17, 1, 4)
+DEFINE_FIELD_BENCH(48, 6, 3)
+
+void report_field_bench(int width, double time_call, double time_inline) {
+    printf("%2d bits: bitcpy %8.2f ms, BITCPY_INLINE %8.2f ms (%.2fx)\n",
+           width, time_call, time_inline, time_call / time_inline);
+}
+
+// 可变宽度字段序列化：手动维护字节指针和位偏移逐字段调用 bitcpy()，对比 bitstream_put_bits
+#define ENCODE_FIELDS 65536
+#define ENCODE_ITERATIONS 200
+
+static const unsigned encode_widths[8] = {3, 12, 17, 5, 48, 1, 9, 30};
+static uint64_t encode_values[ENCODE_FIELDS];
+static uint8_t encode_buf[ENCODE_FIELDS * 8];
+
+double benchmark_encode_bitcpy(void) {
+    double start = get_time_ms();
+    for (int iter = 0; iter < ENCODE_ITERATIONS; iter++) {
+        uint8_t* p = encode_buf;
+        uint8_t bit = 0;
+        for (int i = 0; i < ENCODE_FIELDS; i++) {
+            unsigned w = encode_widths[i & 7];
+            bitcpy(p, bit, (const uint8_t*)&encode_values[i], 0, w);
+            p += (bit + w) >> 3;
+            bit = (bit + w) & 7;
+        }
+    }
+    return get_time_ms() - start;
+}
+
+double benchmark_encode_bitstream(void) {
+    double start = get_time_ms();
+    for (int iter = 0; iter < ENCODE_ITERATIONS; iter++) {
+        bitstream_writer w;
+        bitstream_writer_init(&w, encode_buf, 0);
+        for (int i = 0; i < ENCODE_FIELDS; i++) {
+            bitstream_put_bits(&w, encode_values[i], encode_widths[i & 7]);
+        }
+        bitstream_writer_flush(&w);
+    }
+    return get_time_ms() - start;
+}
+
+// 整数数组位打包：逐元素调用 bitcpy() 对比 bitpack32/bitunpack32，结果为每秒处理的值个数
+#define PACK_VALUES 65536
+#define PACK_ITERATIONS 200
+#define PACK_BIT 3
+
+static uint32_t pack_values[PACK_VALUES];
+static uint32_t pack_unpacked[PACK_VALUES];
+static uint8_t pack_buf[PACK_VALUES * 4 + 1];
+
+// 返回值个数/秒（百万）；mode 0: bitcpy 打包，1: bitpack32，2: bitcpy 解包，3: bitunpack32
+double benchmark_pack(unsigned width, int mode) {
+    double start = get_time_ms();
+    for (int iter = 0; iter < PACK_ITERATIONS; iter++) {
+        switch (mode) {
+        case 0:
+            for (int i = 0; i < PACK_VALUES; i++) {
+                uint64_t pos = PACK_BIT + (uint64_t)i * width;
+                bitcpy(pack_buf + (pos >> 3), pos & 7, (const uint8_t*)&pack_values[i], 0, width);
+            }
+            break;
+        case 1:
+            bitpack32(pack_buf, PACK_BIT, pack_values, PACK_VALUES, width);
+            break;
+        case 2:
+            for (int i = 0; i < PACK_VALUES; i++) {
+                uint64_t pos = PACK_BIT + (uint64_t)i * width;
+                pack_unpacked[i] = 0;
+                bitcpy((uint8_t*)&pack_unpacked[i], 0, pack_buf + (pos >> 3), pos & 7, width);
+            }
+            break;
+        default:
+            bitunpack32(pack_unpacked, pack_buf, PACK_BIT, PACK_VALUES, width);
+            break;
+        }
+    }
+    double ms = get_time_ms() - start;
+    return (double)PACK_VALUES * PACK_ITERATIONS / (ms * 1000.0);
+}
+
+// 1 位/像素位图块传送：逐行 bitcpy()/bitop() 对比 bitblit()，返回 ms。
+// 目标是 4096x1024 的位图（行步长 512 字节），源是同样步长的位图；
+// 窄块模拟字形（23x32，x 偏移依次变化），宽块模拟蒙版（2000x1024，src_x=3，dst_x=6）
+#define BLIT_STRIDE 512
+#define BLIT_ROWS 1024
+#define GLYPH_WIDTH 23
+#define GLYPH_HEIGHT 32
+#define GLYPH_BLITS 200000
+#define MASK_WIDTH 2000
+#define MASK_ITERATIONS 200
+
+static void blit_rows(uint8_t* dst, uint64_t dst_x, const uint8_t* src, uint64_t src_x,
+                      uint64_t width, uint64_t height, int xor_rop) {
+    for (uint64_t y = 0; y < height; y++) {
+        uint8_t* d = dst + y * BLIT_STRIDE + (dst_x >> 3);
+        const uint8_t* s = src + y * BLIT_STRIDE + (src_x >> 3);
+        if (xor_rop) {
+            bitop(d, dst_x & 7, d, dst_x & 7, s, src_x & 7, width, BITOP_XOR);
+        } else {
+            bitcpy(d, dst_x & 7, s, src_x & 7, width);
+        }
+    }
+}
+
+// wide 选择宽块，xor_rop 选择 XOR（否则 COPY），use_blit 选择 bitblit()（否则逐行调用）
+double benchmark_blit(int wide, int xor_rop, int use_blit, uint8_t* dst, const uint8_t* src) {
+    bitblit_rop rop = xor_rop ? BITBLIT_XOR : BITBLIT_COPY;
+    double start = get_time_ms();
+    if (wide) {
+        for (int iter = 0; iter < MASK_ITERATIONS; iter++) {
+            if (use_blit) {
+                bitblit(dst, BLIT_STRIDE, 6, src, BLIT_STRIDE, 3, MASK_WIDTH, BLIT_ROWS, rop);
+            } else {
+                blit_rows(dst, 6, src, 3, MASK_WIDTH, BLIT_ROWS, xor_rop);
+            }
+        }
+    } else {
+        for (int i = 0; i < GLYPH_BLITS; i++) {
+            // 字形在目标中逐个排开，换行后从下一行字形继续；源字形取自源位图第 0 行的 100 个位置之一
+            uint64_t dst_x = (uint64_t)(i % 170) * (GLYPH_WIDTH + 1);
+            uint64_t row = (uint64_t)(i / 170 % (BLIT_ROWS / GLYPH_HEIGHT)) * GLYPH_HEIGHT;
+            uint64_t src_x = (uint64_t)(i % 100) * GLYPH_WIDTH;
+            uint8_t* d = dst + row * BLIT_STRIDE;
+            if (use_blit) {
+                bitblit(d, BLIT_STRIDE, dst_x, src, BLIT_STRIDE, src_x, GLYPH_WIDTH, GLYPH_HEIGHT, rop);
+            } else {
+                blit_rows(d, dst_x, src, src_x, GLYPH_WIDTH, GLYPH_HEIGHT, xor_rop);
+            }
+        }
+    }
+    return get_time_ms() - start;
+}
+
+// 记录布局转换：紧凑的 24 字节记录（20 个 1-17 位字段共 138 位）拆到每字段占一个 24 位槽的 64 字节记录，
+// 逐字段 bitcpy() 对比预编译计划，返回 Mrecords/s
+#define PLAN_FIELDS 20
+#define PLAN_RECORDS 100000
+#define PLAN_ITERATIONS 20
+#define PLAN_SRC_STRIDE 24
+#define PLAN_DST_STRIDE 64
+
+static const unsigned plan_widths[PLAN_FIELDS] = {3, 12, 17, 5, 1, 1, 9, 4, 4, 16, 7, 2, 13, 6, 8, 1, 11, 3, 5, 10};
+
+double benchmark_plan(int use_plan) {
+    bitcpy_field fields[PLAN_FIELDS];
+    uint64_t src_pos = 0;
+    for (int i = 0; i < PLAN_FIELDS; i++) {
+        fields[i].src_off = src_pos;
+        fields[i].len = plan_widths[i];
+        src_pos += plan_widths[i];
+        // 目标布局：字段从各自 24 位槽的起点开始，但每 4 个字段中有一个紧接在前一个之后，两边都首尾相接
+        fields[i].dst_off = (i % 4 == 1) ? fields[i - 1].dst_off + plan_widths[i - 1] : (uint64_t)i * 24;
+    }
+    uint8_t* src = (uint8_t*)malloc((size_t)PLAN_RECORDS * PLAN_SRC_STRIDE);
+    uint8_t* dst = (uint8_t*)calloc((size_t)PLAN_RECORDS * PLAN_DST_STRIDE, 1);
+    bitcpy_plan* plan = bitcpy_plan_compile(fields, PLAN_FIELDS, PLAN_SRC_STRIDE, PLAN_DST_STRIDE);
+    double rate = 0.0;
+    if (src && dst && plan) {
+        for (size_t i = 0; i < (size_t)PLAN_RECORDS * PLAN_SRC_STRIDE; i++) {
+            src[i] = (uint8_t)rand();
+        }
+        double start = get_time_ms();
+        for (int iter = 0; iter < PLAN_ITERATIONS; iter++) {
+            if (use_plan) {
+                bitcpy_plan_apply(plan, dst, src, PLAN_RECORDS);
+                continue;
+            }
+            for (size_t r = 0; r < PLAN_RECORDS; r++) {
+                const uint8_t* s = src + r * PLAN_SRC_STRIDE;
+                uint8_t* d = dst + r * PLAN_DST_STRIDE;
+                for (int i = 0; i < PLAN_FIELDS; i++) {
+                    bitcpy(d + (fields[i].dst_off >> 3), fields[i].dst_off & 7,
+                           s + (fields[i].src_off >> 3), fields[i].src_off & 7, fields[i].len);
+                }
+            }
+        }
+        double ms = get_time_ms() - start;
+        rate = (double)PLAN_RECORDS * PLAN_ITERATIONS / (ms * 1000.0);
+    }
+    free(src);
+    free(dst);
+    bitcpy_plan_free(plan);
+    return rate;
+}
+
+// 位环形缓冲区的跨线程吞吐量：生产者线程写入固定长度的记录，调用线程读出，返回 Gbit/s
+#define RING_BYTES (64u << 10)
+#define RING_DATA_BYTES (1u << 20)
+#define RING_TOTAL_BITS ((uint64_t)1 << 28)
+
+typedef struct {
+    bitring* ring;
+    const uint8_t* src;
+    uint64_t rec_bits;
+} ring_bench_arg;
+
+static void* ring_bench_producer(void* p) {
+    ring_bench_arg* a = (ring_bench_arg*)p;
+    uint64_t span = (uint64_t)RING_DATA_BYTES * 8 - a->rec_bits;
+    uint64_t pos = 0;
+    for (uint64_t done = 0; done + a->rec_bits <= RING_TOTAL_BITS; done += a->rec_bits) {
+        while (!bitring_push(a->ring, a->src + (pos >> 3), pos & 7, a->rec_bits)) {
+            sched_yield();
+        }
+        pos = (pos + a->rec_bits) % span;
+    }
+    return NULL;
+}
+
+double benchmark_ring(uint64_t rec_bits) {
+    uint8_t* ring_buf = (uint8_t*)malloc(RING_BYTES);
+    uint8_t* src = (uint8_t*)malloc(RING_DATA_BYTES);
+    uint8_t* dest = (uint8_t*)malloc(RING_DATA_BYTES);
+    double gbps = 0.0;
+    if (ring_buf && src && dest) {
+        for (size_t i = 0; i < RING_DATA_BYTES; i++) {
+            src[i] = (uint8_t)rand();
+        }
+        bitring ring;
+        bitring_init(&ring, ring_buf, RING_BYTES);
+        ring_bench_arg arg = {&ring, src, rec_bits};
+        uint64_t span = (uint64_t)RING_DATA_BYTES * 8 - rec_bits;
+        uint64_t pos = 0, done = 0;
+        
+        double start = get_time_ms();
+        pthread_t producer;
+        if (pthread_create(&producer, NULL, ring_bench_producer, &arg) == 0) {
+            for (; done + rec_bits <= RING_TOTAL_BITS; done += rec_bits) {
+                while (!bitring_pop(&ring, dest + (pos >> 3), pos & 7, rec_bits)) {
+                    sched_yield();
+                }
+                pos = (pos + rec_bits) % span;
+            }
+            pthread_join(producer, NULL);
+            gbps = (double)done / ((get_time_ms() - start) / 1000.0) / 1e9;
+        }
+    }
+    free(ring_buf);
+    free(src);
+    free(dest);
+    return gbps;
+}
+
 int main(void) {
     printf("Initializing %d test samples...\n", NUM_SAMPLES);
     init_samples();
@@ -203,16 +815,26 @@ int main(void) {
     
     // 正式测试
     double time_bitcpy = benchmark_bitcpy();
+    double time_padded = benchmark_bitcpy_padded();
+    double time_batch = benchmark_bitcpy_batch();
     double time_bitwise = benchmark_bitwise();
     double time_expanded = benchmark_expanded();
     
     printf("=== Performance Results ===\n");
     printf("bitcpy (optimized):   %8.2f ms\n", time_bitcpy);
+    printf("bitcpy_padded:        %8.2f ms\n", time_padded);
+    printf("bitcpy_batch:         %8.2f ms\n", time_batch);
     printf("bitwise (bit-by-bit): %8.2f ms\n", time_bitwise);
     printf("expanded (1byte/bit): %8.2f ms\n", time_expanded);
     printf("\n");
     
     printf("bitcpy vs bitwise:  %.2fx faster\n", time_bitwise / time_bitcpy);
+    printf("padded vs bitcpy:   %.2fx %s\n",
+           time_padded < time_bitcpy ? time_bitcpy / time_padded : time_padded / time_bitcpy,
+           time_padded < time_bitcpy ? "faster" : "slower");
+    printf("batch vs bitcpy:    %.2fx %s\n",
+           time_batch < time_bitcpy ? time_bitcpy / time_batch : time_batch / time_bitcpy,
+           time_batch < time_bitcpy ? "faster" : "slower");
     printf("bitcpy vs expanded: %.2fx %s\n", 
            time_bitcpy < time_expanded ? time_expanded / time_bitcpy : time_bitcpy / time_expanded,
            time_bitcpy < time_expanded ? "faster" : "slower");
@@ -236,6 +858,159 @@ int main(void) {
     printf("Expanded storage:     %llu bytes\n", (unsigned long long)expanded_bytes);
     printf("Memory ratio:         %.2fx\n", (double)expanded_bytes / compact_bytes);
     
+    printf("\n=== Large Copy (%u MiB x %d) ===\n", LARGE_BYTES >> 20, LARGE_ITERATIONS);
+    printf("aligned    (src_bit=0, dest_bit=0): %6.2f GB/s\n", benchmark_bitcpy_large(bitcpy, 0, 0));
+    printf("misaligned (src_bit=3, dest_bit=0): %6.2f GB/s\n", benchmark_bitcpy_large(bitcpy, 3, 0));
+    printf("misaligned (src_bit=5, dest_bit=2): %6.2f GB/s\n", benchmark_bitcpy_large(bitcpy, 5, 2));
+    printf("bitcpy_msb (src_bit=5, dest_bit=2): %6.2f GB/s\n", benchmark_bitcpy_large(bitcpy_msb, 5, 2));
+    
+    printf("\n=== Range Clear (%u MiB x %d, dest_bit=3) ===\n", LARGE_BYTES >> 20, LARGE_ITERATIONS);
+    printf("bitcpy from zero buffer: %6.2f GB/s\n", benchmark_fill(0));
+    printf("bitfill:                 %6.2f GB/s\n", benchmark_fill(1));
+    
+    double time_scratch = benchmark_bitop(0);
+    double time_bitop = benchmark_bitop(1);
+    printf("\n=== Misaligned AND (%u MiB x %d) ===\n", BITOP_BYTES >> 20, BITOP_ITERATIONS);
+    printf("bitcpy + scratch AND: %8.2f ms\n", time_scratch);
+    printf("bitop:                %8.2f ms (%.2fx)\n", time_bitop, time_scratch / time_bitop);
+    
+    scan_buf = (uint8_t*)malloc(SCAN_BYTES);
+    if (scan_buf) {
+        for (size_t i = 0; i < SCAN_BYTES; i++) {
+            scan_buf[i] = (uint8_t)rand();
+        }
+        double time_count_bitwise = benchmark_scan(0);
+        double time_count = benchmark_scan(1);
+        memset(scan_buf, 0, SCAN_BYTES);
+        scan_buf[SCAN_BYTES - 3] = 0x10;
+        double time_find_bitwise = benchmark_scan(2);
+        double time_find = benchmark_scan(3);
+        printf("\n=== Range Count / Find (%u MiB x %d) ===\n", SCAN_BYTES >> 20, SCAN_ITERATIONS);
+        printf("bit-by-bit count: %8.2f ms, bitcount    %8.2f ms (%.2fx)\n",
+               time_count_bitwise, time_count, time_count_bitwise / time_count);
+        printf("bit-by-bit find:  %8.2f ms, bitfind_set %8.2f ms (%.2fx)\n",
+               time_find_bitwise, time_find, time_find_bitwise / time_find);
+        free(scan_buf);
+    }
+    
+    uint8_t* expand_src = (uint8_t*)malloc(EXPAND_BITS / 8);
+    uint8_t* expand_dst = (uint8_t*)malloc(EXPAND_BITS);
+    if (expand_src && expand_dst) {
+        for (size_t i = 0; i < EXPAND_BITS / 8; i++) {
+            expand_src[i] = (uint8_t)rand();
+        }
+        double time_expand_bitwise = benchmark_expand(0, expand_src, expand_dst);
+        double time_expand = benchmark_expand(1, expand_src, expand_dst);
+        double time_compact_bitwise = benchmark_expand(2, expand_src, expand_dst);
+        double time_compact = benchmark_expand(3, expand_src, expand_dst);
+        printf("\n=== Bits <-> Byte-per-Bit (%u Mbit x %d, bit offset 3) ===\n",
+               EXPAND_BITS >> 20, EXPAND_ITERATIONS);
+        printf("expand_bits:  %8.2f ms, bits_to_bytes %8.2f ms (%.2fx)\n",
+               time_expand_bitwise, time_expand, time_expand_bitwise / time_expand);
+        printf("compact_bits: %8.2f ms, bytes_to_bits %8.2f ms (%.2fx)\n",
+               time_compact_bitwise, time_compact, time_compact_bitwise / time_compact);
+    }
+    free(expand_src);
+    free(expand_dst);
+    
+    double time_cmp_scratch = benchmark_cmp(0);
+    double time_cmp = benchmark_cmp(1);
+    printf("\n=== Misaligned Compare (%u MiB x %d, equal ranges) ===\n", BITOP_BYTES >> 20, BITOP_ITERATIONS);
+    printf("bitcpy + memcmp: %8.2f ms\n", time_cmp_scratch);
+    printf("bitequal:        %8.2f ms (%.2fx)\n", time_cmp, time_cmp_scratch / time_cmp);
+    
+    double time_splice_scratch = benchmark_splice(0);
+    double time_splice = benchmark_splice(1);
+    printf("\n=== Insert + Delete 13 Bits (%u MiB vector x %d) ===\n", SPLICE_BYTES >> 20, SPLICE_ITERATIONS);
+    printf("bitcpy via scratch:    %8.2f ms\n", time_splice_scratch);
+    printf("bitinsert + bitdelete: %8.2f ms (%.2fx)\n", time_splice, time_splice_scratch / time_splice);
+    
+    double stream_gbps, stream_hot, cached_gbps, cached_hot;
+    benchmark_stream(bitcpy, &cached_gbps, &cached_hot);
+    benchmark_stream(bitcpy_stream, &stream_gbps, &stream_hot);
+    printf("\n=== Streaming Copy (%u MiB copy, %u KiB hot set, %d rounds) ===\n",
+           STREAM_BYTES >> 20, HOT_BYTES >> 10, STREAM_ROUNDS);
+    printf("bitcpy:        %6.2f GB/s, hot set pass after copy %6.3f ms\n", cached_gbps, cached_hot);
+    printf("bitcpy_stream: %6.2f GB/s, hot set pass after copy %6.3f ms\n", stream_gbps, stream_hot);
+    
+    for (size_t i = 0; i < sizeof(field_src); i++) {
+        field_src[i] = (uint8_t)rand();
+    }
+    printf("\n=== Fixed-Width Fields (%d records x %d iterations) ===\n",
+           FIELD_RECORDS, FIELD_ITERATIONS);
+    report_field_bench(3, benchmark_field_call_3(), benchmark_field_inline_3());
+    report_field_bench(12, benchmark_field_call_12(), benchmark_field_inline_12());
+    report_field_bench(17, benchmark_field_call_17(), benchmark_field_inline_17());
+    report_field_bench(48, benchmark_field_call_48(), benchmark_field_inline_48());
+    
+    for (int i = 0; i < ENCODE_FIELDS; i++) {
+        encode_values[i] = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+    }
+    double time_encode_bitcpy = benchmark_encode_bitcpy();
+    double time_encode_stream = benchmark_encode_bitstream();
+    printf("\n=== Field Encoding (%d fields x %d iterations) ===\n",
+           ENCODE_FIELDS, ENCODE_ITERATIONS);
+    printf("bitcpy per field:   %8.2f ms\n", time_encode_bitcpy);
+    printf("bitstream_put_bits: %8.2f ms (%.2fx)\n",
+           time_encode_stream, time_encode_bitcpy / time_encode_stream);
+    
+    for (int i = 0; i < PACK_VALUES; i++) {
+        pack_values[i] = (uint32_t)rand();
+    }
+    printf("\n=== Integer Packing (%d values x %d iterations, Mvalues/s) ===\n",
+           PACK_VALUES, PACK_ITERATIONS);
+    static const unsigned pack_widths[] = {1, 5, 12, 17, 32};
+    for (size_t i = 0; i < sizeof(pack_widths) / sizeof(pack_widths[0]); i++) {
+        unsigned w = pack_widths[i];
+        double call_pack = benchmark_pack(w, 0);
+        double fast_pack = benchmark_pack(w, 1);
+        double call_unpack = benchmark_pack(w, 2);
+        double fast_unpack = benchmark_pack(w, 3);
+        printf("%2u bits: pack   bitcpy %8.1f, bitpack32   %8.1f (%.2fx)\n",
+               w, call_pack, fast_pack, fast_pack / call_pack);
+        printf("         unpack bitcpy %8.1f, bitunpack32 %8.1f (%.2fx)\n",
+               call_unpack, fast_unpack, fast_unpack / call_unpack);
+    }
+    
+    uint8_t* blit_dst = (uint8_t*)malloc((size_t)BLIT_STRIDE * BLIT_ROWS);
+    uint8_t* blit_src = (uint8_t*)malloc((size_t)BLIT_STRIDE * BLIT_ROWS);
+    if (blit_dst && blit_src) {
+        for (size_t i = 0; i < (size_t)BLIT_STRIDE * BLIT_ROWS; i++) {
+            blit_dst[i] = (uint8_t)rand();
+            blit_src[i] = (uint8_t)rand();
+        }
+        printf("\n=== 1-bpp Blit (%d-byte stride) ===\n", BLIT_STRIDE);
+        static const char* blit_names[2][2] = {
+            {"glyph 23x32 x200000 COPY", "glyph 23x32 x200000 XOR "},
+            {"mask 2000x1024 x200 COPY ", "mask 2000x1024 x200 XOR  "},
+        };
+        for (int wide = 0; wide < 2; wide++) {
+            for (int xor_rop = 0; xor_rop < 2; xor_rop++) {
+                double rows = benchmark_blit(wide, xor_rop, 0, blit_dst, blit_src);
+                double blit = benchmark_blit(wide, xor_rop, 1, blit_dst, blit_src);
+                printf("%s: per-row %s %8.2f ms, bitblit %8.2f ms (%.2fx)\n", blit_names[wide][xor_rop],
+                       xor_rop ? "bitop " : "bitcpy", rows, blit, rows / blit);
+            }
+        }
+    }
+    free(blit_dst);
+    free(blit_src);
+    
+    double plan_call = benchmark_plan(0);
+    double plan_fast = benchmark_plan(1);
+    printf("\n=== Record Layout Conversion (%d fields, %d records x %d, Mrecords/s) ===\n",
+           PLAN_FIELDS, PLAN_RECORDS, PLAN_ITERATIONS);
+    printf("bitcpy per field:  %8.2f\n", plan_call);
+    printf("bitcpy_plan_apply: %8.2f (%.2fx)\n", plan_fast, plan_fast / plan_call);
+    
+    printf("\n=== Bit Ring, Producer -> Consumer Thread (%u KiB ring, %llu Mbit) ===\n",
+           RING_BYTES >> 10, (unsigned long long)(RING_TOTAL_BITS >> 20));
+    static const uint64_t ring_records[] = {13, 100, 1000, 8192};
+    for (size_t i = 0; i < sizeof(ring_records) / sizeof(ring_records[0]); i++) {
+        printf("%5llu-bit records: %6.2f Gbit/s\n",
+               (unsigned long long)ring_records[i], benchmark_ring(ring_records[i]));
+    }
+    
     free_samples();
     return 0;
 }